@@ -0,0 +1,155 @@
+#include "AssetRegistry.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+// Absolute path with the same spelling for every way of naming the file, or
+// path itself if it does not resolve
+static std::string canonicalPath(const std::string& path)
+{
+#ifdef _WIN32
+    char buffer[_MAX_PATH];
+    std::string result = _fullpath(buffer, path.c_str(), _MAX_PATH) ? buffer : path;
+
+    // NTFS ignores case and takes either separator
+    for (size_t i = 0; i < result.size(); i++)
+        result[i] = (result[i] == '\\') ? '/' : (char)tolower((unsigned char)result[i]);
+    return result;
+#else
+    char* resolved = realpath(path.c_str(), NULL);
+    if (!resolved)
+        return path;
+    std::string result = resolved;
+    free(resolved);
+    return result;
+#endif
+}
+
+static void releaseModel(ModelAsset* asset)
+{
+    destroyMeshBuffers(asset->mesh);
+    delete asset;
+}
+
+static void releaseTexture(TextureAsset* asset)
+{
+    glDeleteTextures(1, &asset->textureID);
+    glState.invalidate();
+    delete asset;
+}
+
+ModelRef AssetRegistry::loadModel(const std::string& path)
+{
+    unsigned int options = buildMeshlets ? MODEL_OPTION_MESHLETS : 0;
+    std::string canonical = canonicalPath(path);
+    std::ostringstream key;
+    key << canonical << '|' << options << '|' << vertexFormat << '|' << keepCpuData;
+
+    ModelRef model = models[key.str()].lock();
+    if (model)
+    {
+        hits++;
+        return model;
+    }
+    misses++;
+
+    std::unique_ptr<ModelAsset> asset(new ModelAsset());
+    asset->path = canonical;
+    asset->options = options;
+
+    // Same path as a direct load, so a cached model is uploaded straight
+    // from the mapped file
+    ModelLoader loader;
+    loader.vertexFormat = vertexFormat;
+    loader.buildMeshlets = buildMeshlets;
+    loader.keepCpuData = keepCpuData;
+    Mesh& mesh = asset->mesh;
+    mesh = loader.loadModel(path, "");
+    if (!mesh.VAO)
+        return ModelRef();
+
+    asset->gpuBytes = (size_t)(mesh.vertexBytes + mesh.indexBytes);
+    asset->cpuBytes = mesh.vertices.capacity() * sizeof(float) + mesh.indices.capacity() * sizeof(unsigned int)
+        + mesh.submeshes.capacity() * sizeof(Submesh) + mesh.nodes.capacity() * sizeof(ModelNode)
+        + mesh.materials.capacity() * sizeof(ModelMaterial) + mesh.meshlets.capacity() * sizeof(Meshlet);
+
+    model = ModelRef(asset.release(), releaseModel);
+    models[key.str()] = model;
+    return model;
+}
+
+TextureRef AssetRegistry::loadTexture(const std::string& path)
+{
+    std::string canonical = canonicalPath(path);
+    TextureRef texture = textures[canonical].lock();
+    if (texture)
+    {
+        hits++;
+        return texture;
+    }
+    misses++;
+
+    TextureImage image = {};
+    if (!decodeTexture(path, image))
+        return TextureRef();
+
+    std::unique_ptr<TextureAsset> asset(new TextureAsset());
+    asset->path = canonical;
+    asset->textureID = createTexture(image);
+    asset->width = image.width;
+    asset->height = image.height;
+    asset->gpuBytes = (size_t)image.width * image.height * 4 * 4 / 3;
+    freeTexture(image);
+
+    texture = TextureRef(asset.release(), releaseTexture);
+    textures[canonical] = texture;
+    return texture;
+}
+
+void AssetRegistry::prune()
+{
+    for (std::map<std::string, std::weak_ptr<const ModelAsset> >::iterator it = models.begin(); it != models.end();)
+        it = it->second.expired() ? models.erase(it) : std::next(it);
+    for (std::map<std::string, std::weak_ptr<const TextureAsset> >::iterator it = textures.begin(); it != textures.end();)
+        it = it->second.expired() ? textures.erase(it) : std::next(it);
+}
+
+void AssetRegistry::report(std::ostream& out)
+{
+    prune();
+
+    struct Line {
+        std::string path;
+        long users;
+        size_t gpuBytes, cpuBytes;
+    };
+    std::vector<Line> lines;
+    size_t gpuTotal = 0, cpuTotal = 0;
+    for (std::map<std::string, std::weak_ptr<const ModelAsset> >::iterator it = models.begin(); it != models.end(); ++it)
+    {
+        ModelRef model = it->second.lock();
+        Line line = { model->path, it->second.use_count() - 1, model->gpuBytes, model->cpuBytes };
+        lines.push_back(line);
+    }
+    for (std::map<std::string, std::weak_ptr<const TextureAsset> >::iterator it = textures.begin(); it != textures.end(); ++it)
+    {
+        TextureRef texture = it->second.lock();
+        Line line = { texture->path, it->second.use_count() - 1, texture->gpuBytes, 0 };
+        lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.gpuBytes > b.gpuBytes; });
+
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        out << "  " << lines[i].path << ": " << lines[i].users << " users, GPU " << lines[i].gpuBytes / 1024
+            << " KB, CPU " << lines[i].cpuBytes / 1024 << " KB" << std::endl;
+        gpuTotal += lines[i].gpuBytes;
+        cpuTotal += lines[i].cpuBytes;
+    }
+    out << "Assets: " << models.size() << " models, " << textures.size() << " textures, GPU " << gpuTotal / 1024
+        << " KB, CPU " << cpuTotal / 1024 << " KB; " << hits << " requests shared, " << misses << " loaded" << std::endl;
+}
@@ -0,0 +1,58 @@
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include "ModelLoader.h"
+
+struct ModelAsset {
+    std::string path;  // Canonical
+    unsigned int options;
+    Mesh mesh;         // textureID is unused; textures are assets of their own
+    size_t gpuBytes;
+    size_t cpuBytes;
+};
+
+struct TextureAsset {
+    std::string path;  // Canonical
+    GLuint textureID;
+    int width, height;
+    size_t gpuBytes;   // Estimate: four bytes a texel plus a third for the mips
+};
+
+// Shared handles; the GL objects are deleted when the last handle goes, so
+// handles must be released on the render thread
+typedef std::shared_ptr<const ModelAsset> ModelRef;
+typedef std::shared_ptr<const TextureAsset> TextureRef;
+
+// Loads each model and texture once. Requests are keyed by canonical path
+// (and, for models, the import options, vertex format and keepCpuData); a
+// repeated request returns the live asset instead of loading it again. The
+// registry only holds weak references, so it never keeps an asset alive by
+// itself.
+class AssetRegistry {
+public:
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    bool buildMeshlets = false;  // MODEL_OPTION_MESHLETS
+    bool keepCpuData = false;    // See ModelLoader::keepCpuData
+
+    unsigned int hits = 0;    // Requests served by a live asset
+    unsigned int misses = 0;  // Requests that loaded
+
+    ModelRef loadModel(const std::string& path);  // Null on failure
+    TextureRef loadTexture(const std::string& path);
+
+    // Live assets with their users and memory, largest first
+    void report(std::ostream& out);
+
+private:
+    std::map<std::string, std::weak_ptr<const ModelAsset> > models;
+    std::map<std::string, std::weak_ptr<const TextureAsset> > textures;
+
+    void prune();  // Drop the entries of released assets
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "AsyncModelLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Render thread work of one load, in order
+enum UploadStage {
+    STAGE_CREATE = 0,   // VAO and buffer storage
+    STAGE_VERTICES,
+    STAGE_INDICES,
+    STAGE_TEXTURE,      // Storage, then rows, then mipmaps
+    STAGE_DONE
+};
+
+struct ModelLoadJob {
+    std::string path;
+    std::string texturePath;
+    unsigned int options = 0;
+    bool keepCpuData = false;
+    std::shared_ptr<ModelLoadState> state;
+
+    // Filled by the worker
+    ModelImportReport report;  // Printed by update(), on the render thread
+    Mesh mesh;
+    MeshUploadData upload;
+    TextureImage image = {};
+
+    // Progress on the render thread
+    int stage = STAGE_CREATE;
+    size_t uploaded = 0;  // Bytes of the current buffer, or texture rows
+
+    ~ModelLoadJob() { freeTexture(image); }
+};
+
+static GLenum pixelFormat(int channels)
+{
+    switch (channels)
+    {
+    case 1: return GL_RED;
+    case 2: return GL_RG;
+    case 3: return GL_RGB;
+    default: return GL_RGBA;
+    }
+}
+
+AsyncModelLoader::AsyncModelLoader() : pendingLoads(0)
+{
+}
+
+AsyncModelLoader::~AsyncModelLoader()
+{
+    stop();
+}
+
+void AsyncModelLoader::start(unsigned int workerCount)
+{
+    workerCount = std::max(workerCount, 1u);
+    for (unsigned int i = 0; i < workerCount; i++)
+        importers.push_back(std::unique_ptr<Assimp::Importer>(new Assimp::Importer()));
+    pool.start(workerCount);
+}
+
+void AsyncModelLoader::stop()
+{
+    pool.stop();
+    importers.clear();
+
+    // GL objects of partly uploaded loads are left to the context, which may
+    // already be gone when this runs from the destructor
+    std::deque<std::unique_ptr<ModelLoadJob> >* lists[] = { &queued, &parsed, &uploading };
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++)
+    {
+        for (size_t j = 0; j < lists[i]->size(); j++)
+            (*lists[i])[j]->state->status.store(MODEL_LOAD_FAILED);
+        lists[i]->clear();
+    }
+    pendingLoads.store(0);
+}
+
+ModelHandle AsyncModelLoader::load(const std::string& path, const std::string& texturePath)
+{
+    std::unique_ptr<ModelLoadJob> job(new ModelLoadJob());
+    job->path = path;
+    job->texturePath = texturePath;
+    job->options = buildMeshlets ? MODEL_OPTION_MESHLETS : 0;
+    job->keepCpuData = keepCpuData;
+    job->mesh.format = vertexFormat;
+    job->state = std::make_shared<ModelLoadState>();
+
+    ModelHandle handle;
+    handle.state = job->state;
+    pendingLoads++;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(job));
+    }
+    pool.submit([this](unsigned int worker) { readNext(worker); });
+    return handle;
+}
+
+// One task per load; the task takes whichever job is oldest
+void AsyncModelLoader::readNext(unsigned int worker)
+{
+    std::unique_ptr<ModelLoadJob> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued.empty())
+            return;
+        job = std::move(queued.front());
+        queued.pop_front();
+    }
+
+    if (!readModel(job->path, job->options, job->mesh, importers[worker].get(), &job->report))
+    {
+        std::cerr << "Failed to load model: " << job->path << std::endl;
+        job->state->status.store(MODEL_LOAD_FAILED);
+        pendingLoads--;
+        return;
+    }
+    prepareMeshUpload(job->mesh, job->mesh.vertices.data(), job->mesh.vertices.size() / MODEL_VERTEX_FLOATS,
+        job->mesh.indices.data(), job->mesh.indices.size(), job->upload);
+
+    // Sources that were converted are not needed for the upload itself
+    if (!job->keepCpuData && !job->upload.packedVertices.empty())
+    {
+        job->upload.vertices = NULL;
+        std::vector<float>().swap(job->mesh.vertices);
+    }
+    if (!job->keepCpuData && !job->upload.narrowIndices.empty())
+    {
+        job->upload.indices = NULL;
+        std::vector<unsigned int>().swap(job->mesh.indices);
+    }
+    if (!job->texturePath.empty())
+        decodeTexture(job->texturePath, job->image);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    parsed.push_back(std::move(job));
+}
+
+// Advance one load by one step; returns the bytes sent to GL
+size_t AsyncModelLoader::uploadStep(ModelLoadJob& job)
+{
+    switch (job.stage)
+    {
+    case STAGE_CREATE:
+        createMeshBuffers(job.mesh, job.upload, false);
+        job.stage = STAGE_VERTICES;
+        job.uploaded = 0;
+        return 0;
+
+    case STAGE_VERTICES:
+    case STAGE_INDICES:
+    {
+        bool vertices = job.stage == STAGE_VERTICES;
+        GLuint buffer = vertices ? job.mesh.VBO : job.mesh.EBO;
+        const unsigned char* data = (const unsigned char*)(vertices ? job.upload.vertexData() : job.upload.indexData());
+        size_t total = vertices ? job.upload.vertexBytes : job.upload.indexBytes;
+        size_t size = std::min(ASYNC_UPLOAD_CHUNK_BYTES, total - job.uploaded);
+        if (size > 0)
+            glNamedBufferSubData(buffer, (GLintptr)job.uploaded, (GLsizeiptr)size, data + job.uploaded);
+        job.uploaded += size;
+        if (job.uploaded == total)
+        {
+            job.stage++;
+            job.uploaded = 0;
+        }
+        return size;
+    }
+
+    case STAGE_TEXTURE:
+    {
+        TextureImage& image = job.image;
+        if (!image.pixels)
+        {
+            job.stage = STAGE_DONE;
+            return 0;
+        }
+
+        if (job.mesh.textureID == 0)
+        {
+            GLsizei levels = 1 + (GLsizei)floor(log2((double)std::max(image.width, image.height)));
+            glCreateTextures(GL_TEXTURE_2D, 1, &job.mesh.textureID);
+            glTextureStorage2D(job.mesh.textureID, levels, (image.channels == 3) ? GL_RGB8 : GL_RGBA8, image.width, image.height);
+        }
+
+        // stb_image rows are tightly packed
+        size_t rowBytes = (size_t)image.width * image.channels;
+        size_t rows = std::min(std::max(ASYNC_UPLOAD_CHUNK_BYTES / rowBytes, (size_t)1), (size_t)image.height - job.uploaded);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(job.mesh.textureID, 0, 0, (GLint)job.uploaded, image.width, (GLsizei)rows,
+            pixelFormat(image.channels), GL_UNSIGNED_BYTE, image.pixels + job.uploaded * rowBytes);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        job.uploaded += rows;
+
+        if (job.uploaded == (size_t)image.height)
+        {
+            glGenerateTextureMipmap(job.mesh.textureID);
+            freeTexture(image);
+            job.stage = STAGE_DONE;
+        }
+        return rows * rowBytes;
+    }
+
+    default:
+        return 0;
+    }
+}
+
+size_t AsyncModelLoader::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!parsed.empty())
+        {
+            uploading.push_back(std::move(parsed.front()));
+            parsed.pop_front();
+        }
+    }
+
+    // At least one step that moves data, then only while under budget
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    while (!uploading.empty())
+    {
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (bytes > 0 && (bytes >= uploadBytesPerFrame || elapsedMs >= uploadMsPerFrame))
+            break;
+
+        ModelLoadJob& job = *uploading.front();
+        bytes += uploadStep(job);
+        if (job.stage == STAGE_DONE)
+        {
+            job.report.print(std::cout, job.path);
+            if (!job.keepCpuData)
+                releaseCpuData(job.mesh);
+            job.state->mesh = std::move(job.mesh);
+            job.state->status.store(MODEL_LOAD_READY);
+            uploading.pop_front();
+            pendingLoads--;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,92 @@
+#ifndef ASYNCMODELLOADER_H
+#define ASYNCMODELLOADER_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+#include "ThreadPool.h"
+
+// Default GL upload budget of one frame. A step of work is never split
+// below ASYNC_UPLOAD_CHUNK_BYTES, and at least one step runs per frame so
+// loads always progress.
+const size_t ASYNC_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+const double ASYNC_UPLOAD_MS_PER_FRAME = 2.0;
+const size_t ASYNC_UPLOAD_CHUNK_BYTES = 256 * 1024;
+const unsigned int ASYNC_LOADER_WORKERS = 2;
+
+enum ModelLoadStatus {
+    MODEL_LOAD_PENDING = 0,
+    MODEL_LOAD_READY,
+    MODEL_LOAD_FAILED
+};
+
+struct ModelLoadState {
+    std::atomic<int> status{ MODEL_LOAD_PENDING };
+    Mesh mesh;  // Complete once status is MODEL_LOAD_READY
+};
+
+// Future-like result of AsyncModelLoader::load. Poll it from the render
+// thread; the mesh is only available once the GL upload has finished.
+class ModelHandle {
+public:
+    bool valid() const { return state != NULL; }
+    bool ready() const { return state && state->status.load() == MODEL_LOAD_READY; }
+    bool failed() const { return state && state->status.load() == MODEL_LOAD_FAILED; }
+    const Mesh* mesh() const { return ready() ? &state->mesh : NULL; }
+
+private:
+    friend class AsyncModelLoader;
+    std::shared_ptr<ModelLoadState> state;
+};
+
+struct ModelLoadJob;
+
+// Loads models without stalling the frame loop. Worker threads read the
+// .mesh cache or run Assimp, convert the vertices to the GPU format and
+// decode the texture (readModel, prepareMeshUpload, decodeTexture). The
+// render thread then creates the GL objects and streams the data in chunks
+// from update(), never spending more than the per-frame budget.
+class AsyncModelLoader {
+public:
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    bool buildMeshlets = false;
+    bool keepCpuData = false;  // See ModelLoader::keepCpuData
+    size_t uploadBytesPerFrame = ASYNC_UPLOAD_BYTES_PER_FRAME;
+    double uploadMsPerFrame = ASYNC_UPLOAD_MS_PER_FRAME;
+
+    AsyncModelLoader();
+    AsyncModelLoader(const AsyncModelLoader&) = delete;
+    AsyncModelLoader& operator=(const AsyncModelLoader&) = delete;
+    ~AsyncModelLoader();
+
+    void start(unsigned int workerCount = ASYNC_LOADER_WORKERS);
+    void stop();  // Waits for running reads; loads not yet uploaded fail
+
+    // texturePath may be empty. Call start() first.
+    ModelHandle load(const std::string& path, const std::string& texturePath);
+
+    // Render thread, once per frame: GL work of the finished loads within the
+    // budget. Returns the bytes uploaded.
+    size_t update();
+
+    size_t inFlight() const { return pendingLoads.load(); }
+
+private:
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Assimp::Importer> > importers;  // One per worker
+    std::mutex mutex;
+    std::deque<std::unique_ptr<ModelLoadJob> > queued;     // Waiting for a worker
+    std::deque<std::unique_ptr<ModelLoadJob> > parsed;     // Waiting for the render thread
+    std::deque<std::unique_ptr<ModelLoadJob> > uploading;  // Render thread only
+    std::atomic<size_t> pendingLoads;
+
+    void readNext(unsigned int worker);
+    size_t uploadStep(ModelLoadJob& job);
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cmath>
+#include <cstddef>
+#include "Vector3.h"
+
+struct AABB {
+    Vector3 min, max;
+};
+
+struct BoundingSphere {
+    Vector3 center;
+    float radius;
+};
+
+// Local-space bounding volumes of a mesh
+struct Bounds {
+    AABB box;
+    BoundingSphere sphere;
+};
+
+// Largest axis scale of the column-major matrix m, keeps spheres and errors
+// conservative under non-uniform scaling
+inline float maxAxisScale(const float* m)
+{
+    float scaleX = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    float scaleY = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    float scaleZ = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    return sqrtf(fmaxf(scaleX, fmaxf(scaleY, scaleZ)));
+}
+
+// sphere placed by the affine column-major matrix m
+inline BoundingSphere transformSphere(const BoundingSphere& sphere, const float* m)
+{
+    const Vector3& c = sphere.center;
+    BoundingSphere result;
+    result.center = Vector3(m[0] * c.x + m[4] * c.y + m[8] * c.z + m[12],
+        m[1] * c.x + m[5] * c.y + m[9] * c.z + m[13],
+        m[2] * c.x + m[6] * c.y + m[10] * c.z + m[14]);
+    result.radius = sphere.radius * maxAxisScale(m);
+    return result;
+}
+
+// Bounds of vertexCount vertices whose position is the first three floats of
+// every stride floats. The sphere is centred on the box and tightened to the
+// farthest vertex.
+inline Bounds computeBounds(const float* vertices, size_t vertexCount, size_t stride)
+{
+    Bounds bounds = {};
+    if (vertexCount == 0)
+        return bounds;
+
+    bounds.box.min = Vector3(vertices[0], vertices[1], vertices[2]);
+    bounds.box.max = bounds.box.min;
+    for (size_t i = 1; i < vertexCount; i++)
+    {
+        const float* p = vertices + i * stride;
+        bounds.box.min = Vector3(fminf(bounds.box.min.x, p[0]), fminf(bounds.box.min.y, p[1]), fminf(bounds.box.min.z, p[2]));
+        bounds.box.max = Vector3(fmaxf(bounds.box.max.x, p[0]), fmaxf(bounds.box.max.y, p[1]), fmaxf(bounds.box.max.z, p[2]));
+    }
+
+    Vector3 center = (bounds.box.min + bounds.box.max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* p = vertices + i * stride;
+        float dx = p[0] - center.x, dy = p[1] - center.y, dz = p[2] - center.z;
+        radiusSquared = fmaxf(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+
+    bounds.sphere.center = center;
+    bounds.sphere.radius = sqrtf(radiusSquared);
+    return bounds;
+}
+
+#endif
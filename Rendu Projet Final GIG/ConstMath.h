@@ -0,0 +1,67 @@
+#ifndef CONSTMATH_H
+#define CONSTMATH_H
+
+// constexpr replacements for the <cmath> functions Mat4 needs, so constant
+// transforms can be evaluated at compile time. Computed in double and
+// accurate to float precision; also fine to call at runtime.
+
+constexpr double CONST_PI = 3.14159265358979323846;
+
+constexpr float constAbs(float x)
+{
+    return x < 0.0f ? -x : x;
+}
+
+// Taylor series on [-pi/2, pi/2], after folding the angle into that range
+constexpr double constSinDouble(double x)
+{
+    double turns = x / (2.0 * CONST_PI);
+    long long whole = (long long)(turns + (turns >= 0.0 ? 0.5 : -0.5));
+    x -= (double)whole * 2.0 * CONST_PI;  // [-pi, pi]
+    if (x > CONST_PI * 0.5)
+        x = CONST_PI - x;
+    else if (x < -CONST_PI * 0.5)
+        x = -CONST_PI - x;
+
+    double term = x, sum = x, x2 = x * x;
+    for (int n = 1; n <= 9; n++)
+    {
+        term *= -x2 / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr float constSin(float x)
+{
+    return (float)constSinDouble(x);
+}
+
+constexpr float constCos(float x)
+{
+    return (float)constSinDouble((double)x + CONST_PI * 0.5);
+}
+
+constexpr float constTan(float x)
+{
+    return (float)(constSinDouble(x) / constSinDouble((double)x + CONST_PI * 0.5));
+}
+
+// Newton-Raphson; 0 for non-positive input
+constexpr float constSqrt(float x)
+{
+    if (!(x > 0.0f))
+        return 0.0f;
+
+    double value = x, guess = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 64; i++)
+    {
+        double next = 0.5 * (guess + value / guess);
+        if (next == guess)
+            break;
+        guess = next;
+    }
+    return (float)guess;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#include "FrameData.h"
+#include "GLStateCache.h"
+#include <cstddef>
+
+GLuint createFrameDataBuffer()
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glState.bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+    glState.bindBuffer(GL_UNIFORM_BUFFER, 0);
+    return buffer;
+}
+
+// Upload this frame's camera and lighting and bind it for every program
+void updateFrameDataBuffer(GLuint buffer, const FrameData& data)
+{
+    glNamedBufferSubData(buffer, 0, sizeof(FrameData), &data);
+    glState.bindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, buffer);
+}
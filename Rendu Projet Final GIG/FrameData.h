@@ -0,0 +1,32 @@
+#ifndef FRAMEDATA_H
+#define FRAMEDATA_H
+
+#include <glad/glad.h>
+
+// Uniform buffer binding point of the FrameData block in every shader
+const GLuint FRAME_DATA_BINDING = 0;
+
+// CPU mirror of the std140 FrameData uniform block:
+//
+// layout (std140, binding = 0) uniform FrameData
+// {
+//     mat4 view;
+//     mat4 projection;
+//     vec4 cameraPos;
+//     vec4 lightDir;
+//     vec4 lightColor;
+// };
+struct FrameData {
+    float view[16];
+    float projection[16];
+    float cameraPos[4];
+    float lightDir[4];
+    float lightColor[4];
+};
+
+static_assert(sizeof(FrameData) == 176, "FrameData must match the std140 block layout");
+
+GLuint createFrameDataBuffer();
+void updateFrameDataBuffer(GLuint buffer, const FrameData& data);
+
+#endif
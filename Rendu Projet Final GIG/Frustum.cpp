@@ -0,0 +1,84 @@
+#include "Frustum.h"
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE 1
+#include <xmmintrin.h>
+#endif
+
+Frustum extractFrustum(const Mat4& viewProjection)
+{
+    const float* m = viewProjection.m;
+    Frustum frustum;
+
+    // Gribb-Hartmann: each plane is row 3 plus or minus row 0, 1 or 2
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            frustum.planes[i * 2][j] = m[j * 4 + 3] + m[j * 4 + i];
+            frustum.planes[i * 2 + 1][j] = m[j * 4 + 3] - m[j * 4 + i];
+        }
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        float* plane = frustum.planes[i];
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        for (int j = 0; j < 4; j++)
+            plane[j] /= length;
+    }
+    return frustum;
+}
+
+static bool sphereVisible(const Frustum& frustum, float x, float y, float z, float r)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const float* plane = frustum.planes[i];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < -r)
+            return false;
+    }
+    return true;
+}
+
+size_t cullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+    const float* radius, size_t count, unsigned char* visible)
+{
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(centerX + i);
+        __m128 y = _mm_loadu_ps(centerY + i);
+        __m128 z = _mm_loadu_ps(centerZ + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+        __m128 inside = _mm_cmpeq_ps(x, x);  // All lanes set (centers are never NaN)
+        for (int p = 0; p < 6; p++)
+        {
+            const float* plane = frustum.planes[p];
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            visible[i + lane] = (unsigned char)((mask >> lane) & 1);
+            visibleCount += visible[i + lane];
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        visible[i] = sphereVisible(frustum, centerX[i], centerY[i], centerZ[i], radius[i]) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
@@ -0,0 +1,22 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <cstddef>
+#include "Mat4.h"
+
+// Six normalized planes (a, b, c, d); a point p is inside when a*x + b*y + c*z + d >= 0.
+// Order: left, right, bottom, top, near, far.
+struct Frustum {
+    float planes[6][4];
+};
+
+// Planes of the clip volume of viewProjection (projection * view gives world-space planes)
+Frustum extractFrustum(const Mat4& viewProjection);
+
+// Test count spheres given as separate x/y/z/radius arrays, four at a time
+// with SSE. visible[i] is set to 1 when sphere i intersects the frustum.
+// Returns the number of visible spheres.
+size_t cullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+    const float* radius, size_t count, unsigned char* visible);
+
+#endif
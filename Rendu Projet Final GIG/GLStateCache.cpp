@@ -0,0 +1,150 @@
+#include "GLStateCache.h"
+
+GLStateCache glState;
+
+// Value that never matches a real binding, used after invalidate()
+static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+int GLStateCache::bufferTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return ARRAY;
+    case GL_UNIFORM_BUFFER: return UNIFORM;
+    case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT;
+    case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE;
+    case GL_PIXEL_PACK_BUFFER: return PIXEL_PACK;
+    default: return -1;
+    }
+}
+
+int GLStateCache::textureTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D: return TEXTURE_2D;
+    case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+    default: return -1;
+    }
+}
+
+// Count the call, true if it has to be forwarded to GL
+bool GLStateCache::track(bool redundant)
+{
+    if (redundant)
+    {
+        skipped++;
+        return false;
+    }
+    issued++;
+    return true;
+}
+
+void GLStateCache::useProgram(GLuint id)
+{
+    if (track(program == id))
+    {
+        glUseProgram(id);
+        program = id;
+    }
+}
+
+void GLStateCache::bindVertexArray(GLuint id)
+{
+    if (track(vertexArray == id))
+    {
+        glBindVertexArray(id);
+        vertexArray = id;
+    }
+}
+
+void GLStateCache::activeTexture(GLuint unit)
+{
+    if (track(activeUnit == unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    int index = textureTargetIndex(target);
+    if (index < 0 || unit >= GL_STATE_TEXTURE_UNITS)
+    {
+        activeTexture(unit);
+        issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (track(textures[unit][index] == texture))
+    {
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        textures[unit][index] = texture;
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    int index = bufferTargetIndex(target);
+    if (index < 0)
+    {
+        issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (track(buffers[index] == buffer))
+    {
+        glBindBuffer(target, buffer);
+        buffers[index] = buffer;
+    }
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    if (target != GL_UNIFORM_BUFFER || index >= GL_STATE_UNIFORM_BINDINGS)
+    {
+        issued++;
+        glBindBufferBase(target, index, buffer);
+        int generic = bufferTargetIndex(target);
+        if (generic >= 0)
+            buffers[generic] = buffer;
+        return;
+    }
+
+    if (track(uniformBindings[index] == buffer))
+    {
+        glBindBufferBase(target, index, buffer);
+        uniformBindings[index] = buffer;
+        // Binding an indexed target also replaces the generic binding
+        buffers[UNIFORM] = buffer;
+    }
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+    if (track(depth == func))
+    {
+        glDepthFunc(func);
+        depth = func;
+    }
+}
+
+// Forget everything; the next call of each kind is forwarded and re-tracked
+void GLStateCache::invalidate()
+{
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (int i = 0; i < GL_STATE_TEXTURE_UNITS; i++)
+        for (int j = 0; j < TEXTURE_TARGETS; j++)
+            textures[i][j] = UNKNOWN;
+    for (int i = 0; i < BUFFER_TARGETS; i++)
+        buffers[i] = UNKNOWN;
+    for (int i = 0; i < GL_STATE_UNIFORM_BINDINGS; i++)
+        uniformBindings[i] = UNKNOWN;
+    depth = 0;
+}
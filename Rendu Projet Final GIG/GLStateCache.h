@@ -0,0 +1,49 @@
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <glad/glad.h>
+
+const int GL_STATE_TEXTURE_UNITS = 16;
+const int GL_STATE_UNIFORM_BINDINGS = 16;
+
+// Shadow of the GL binding state so redundant binds never reach the driver.
+// Starts from the default state of a fresh context. Every draw and setup path
+// binds through glState; code that changes these bindings behind its back must
+// call invalidate() afterwards.
+//
+// GL_ELEMENT_ARRAY_BUFFER is part of the VAO state and is always forwarded.
+struct GLStateCache {
+    unsigned int issued = 0;   // Calls forwarded to GL
+    unsigned int skipped = 0;  // Redundant calls eliminated
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void activeTexture(GLuint unit);
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void depthFunc(GLenum func);
+
+    void invalidate();
+    void resetCounters() { issued = 0; skipped = 0; }
+
+private:
+    enum { ARRAY, UNIFORM, DRAW_INDIRECT, SHADER_STORAGE, PIXEL_PACK, BUFFER_TARGETS };
+    enum { TEXTURE_2D, TEXTURE_CUBE_MAP, TEXTURE_TARGETS };
+
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    GLuint activeUnit = 0;
+    GLuint textures[GL_STATE_TEXTURE_UNITS][TEXTURE_TARGETS] = {};
+    GLuint buffers[BUFFER_TARGETS] = {};
+    GLuint uniformBindings[GL_STATE_UNIFORM_BINDINGS] = {};
+    GLenum depth = GL_LESS;
+
+    static int bufferTargetIndex(GLenum target);
+    static int textureTargetIndex(GLenum target);
+    bool track(bool redundant);
+};
+
+extern GLStateCache glState;
+
+#endif
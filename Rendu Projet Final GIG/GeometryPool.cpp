@@ -0,0 +1,42 @@
+#include "GeometryPool.h"
+#include "GLStateCache.h"
+
+MeshRange GeometryPool::add(const float* meshVertices, size_t floatCount, const unsigned int* meshIndices, size_t indexCount)
+{
+    MeshRange range;
+    range.firstIndex = (GLuint)indices.size();
+    range.baseVertex = (GLint)(vertices.size() / POOL_VERTEX_FLOATS);
+    range.indexCount = (GLsizei)indexCount;
+    range.bounds = computeBounds(meshVertices, floatCount / POOL_VERTEX_FLOATS, POOL_VERTEX_FLOATS);
+
+    vertices.insert(vertices.end(), meshVertices, meshVertices + floatCount);
+    indices.insert(indices.end(), meshIndices, meshIndices + indexCount);
+    return range;
+}
+
+void GeometryPool::upload()
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glState.bindVertexArray(VAO);
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, POOL_VERTEX_FLOATS * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, POOL_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.bindVertexArray(0);
+
+    std::vector<float>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
@@ -0,0 +1,35 @@
+#ifndef GEOMETRYPOOL_H
+#define GEOMETRYPOOL_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+#include "Bounds.h"
+
+// Where a mesh lives inside a GeometryPool
+struct MeshRange {
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLsizei indexCount;
+    Bounds bounds;  // Local space
+};
+
+// One vertex buffer, one index buffer and one VAO shared by every static mesh
+// with the position + normal layout. Meshes are appended on the CPU, then
+// upload() creates the GL objects and releases the staging copies.
+struct GeometryPool {
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    // Indices are relative to the mesh's own vertices
+    MeshRange add(const float* meshVertices, size_t floatCount, const unsigned int* meshIndices, size_t indexCount);
+    void upload();
+};
+
+const int POOL_VERTEX_FLOATS = 6;  // Position, normal
+
+#endif
@@ -0,0 +1,176 @@
+#include "GpuProfiler.h"
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+int GpuProfiler::sectionIndex(const char* name)
+{
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        if (sections[i].name == name)
+            return (int)i;
+    }
+
+    Section section;
+    section.name = name;
+    memset(section.samples, 0, sizeof(section.samples));
+    section.sampleCount = 0;
+    section.nextSample = 0;
+    sections.push_back(section);
+    return (int)sections.size() - 1;
+}
+
+GLuint GpuProfiler::acquireQuery()
+{
+    if (freeQueries.empty())
+    {
+        GLuint queries[32];
+        glGenQueries(32, queries);
+        freeQueries.insert(freeQueries.end(), queries, queries + 32);
+    }
+    GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+}
+
+// Read a finished frame's timers into the rolling averages and recycle the
+// queries. Timestamps complete in order, so once last (the frame's final
+// query) is available every result can be read without stalling.
+void GpuProfiler::collect(std::vector<Timer>& timers, GLuint last, unsigned int frame)
+{
+    if (timers.empty())
+        return;
+
+    GLint available = 0;
+    glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+        for (size_t i = 0; i < timers.size(); i++)
+        {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(timers[i].start, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(timers[i].end, GL_QUERY_RESULT, &end);
+            double ms = (double)(end - start) / 1000000.0;
+
+            Section& section = sections[timers[i].section];
+            section.samples[section.nextSample] = ms;
+            section.nextSample = (section.nextSample + 1) % GPU_PROFILER_WINDOW;
+            if (section.sampleCount < GPU_PROFILER_WINDOW)
+                section.sampleCount++;
+
+            if (csv.is_open())
+                csv << frame << "," << section.name << "," << ms << "\n";
+        }
+    }
+    else
+    {
+        droppedFrames++;
+    }
+
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        freeQueries.push_back(timers[i].start);
+        freeQueries.push_back(timers[i].end);
+    }
+    timers.clear();
+}
+
+void GpuProfiler::beginFrame()
+{
+    slot = frameIndex % GPU_PROFILER_LATENCY;
+    collect(frames[slot], lastQuery[slot], frameIndex - GPU_PROFILER_LATENCY);
+    lastQuery[slot] = 0;
+}
+
+void GpuProfiler::endFrame()
+{
+    frameIndex++;
+
+    double now = glfwGetTime();
+    if (reportInterval > 0.0 && now - lastReport >= reportInterval)
+    {
+        report(std::cout);
+        lastReport = now;
+    }
+}
+
+void GpuProfiler::begin(const char* name)
+{
+    Timer timer;
+    timer.section = sectionIndex(name);
+    timer.start = acquireQuery();
+    timer.end = 0;
+    glQueryCounter(timer.start, GL_TIMESTAMP);
+    lastQuery[slot] = timer.start;
+
+    openTimers.push_back(frames[slot].size());
+    frames[slot].push_back(timer);
+}
+
+void GpuProfiler::end()
+{
+    if (openTimers.empty())
+        return;
+
+    Timer& timer = frames[slot][openTimers.back()];
+    openTimers.pop_back();
+    timer.end = acquireQuery();
+    glQueryCounter(timer.end, GL_TIMESTAMP);
+    lastQuery[slot] = timer.end;
+}
+
+bool GpuProfiler::openCsv(const char* path)
+{
+    csv.open(path);
+    if (!csv)
+    {
+        std::cerr << "Failed to open GPU timing export: " << path << std::endl;
+        return false;
+    }
+    csv << "frame,section,ms\n";
+    return true;
+}
+
+void GpuProfiler::report(std::ostream& out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "GPU time (avg / min / max ms over last " << GPU_PROFILER_WINDOW << " frames)" << std::endl;
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        const Section& section = sections[i];
+        if (section.sampleCount == 0)
+            continue;
+
+        double total = 0.0, minMs = section.samples[0], maxMs = section.samples[0];
+        for (int j = 0; j < section.sampleCount; j++)
+        {
+            total += section.samples[j];
+            minMs = section.samples[j] < minMs ? section.samples[j] : minMs;
+            maxMs = section.samples[j] > maxMs ? section.samples[j] : maxMs;
+        }
+
+        out << "  " << std::left << std::setw(12) << section.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(8) << total / section.sampleCount << std::setw(8) << minMs << std::setw(8) << maxMs << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void GpuProfiler::destroy()
+{
+    for (int i = 0; i < GPU_PROFILER_LATENCY; i++)
+    {
+        for (size_t j = 0; j < frames[i].size(); j++)
+        {
+            freeQueries.push_back(frames[i][j].start);
+            freeQueries.push_back(frames[i][j].end);
+        }
+        frames[i].clear();
+    }
+    if (!freeQueries.empty())
+        glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+    freeQueries.clear();
+    csv.close();
+}
@@ -0,0 +1,63 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <glad/glad.h>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Frames between issuing a query pair and reading it back, so reading never
+// stalls the pipeline
+const int GPU_PROFILER_LATENCY = 4;
+
+// Samples kept per section for the rolling average
+const int GPU_PROFILER_WINDOW = 64;
+
+// GPU timings of named sections measured with GL_TIMESTAMP query pairs.
+// Sections may nest. Results are read GPU_PROFILER_LATENCY frames later and
+// folded into per-section rolling averages, printed every reportInterval
+// seconds and optionally appended to a CSV file.
+struct GpuProfiler {
+    double reportInterval = 2.0;
+    unsigned int droppedFrames = 0;  // Frames whose results were still not ready when their slot came round
+
+    void beginFrame();
+    void endFrame();
+
+    void begin(const char* name);
+    void end();
+
+    bool openCsv(const char* path);
+    void report(std::ostream& out) const;
+    void destroy();
+
+private:
+    struct Section {
+        std::string name;
+        double samples[GPU_PROFILER_WINDOW];
+        int sampleCount;
+        int nextSample;
+    };
+
+    struct Timer {
+        int section;
+        GLuint start, end;
+    };
+
+    std::vector<Section> sections;
+    std::vector<Timer> frames[GPU_PROFILER_LATENCY];
+    GLuint lastQuery[GPU_PROFILER_LATENCY] = {};  // Query issued last in each frame; nested sections end out of order
+    std::vector<size_t> openTimers;
+    std::vector<GLuint> freeQueries;
+    int slot = 0;
+    unsigned int frameIndex = 0;
+    double lastReport = 0.0;
+    std::ofstream csv;
+
+    int sectionIndex(const char* name);
+    GLuint acquireQuery();
+    void collect(std::vector<Timer>& timers, GLuint last, unsigned int frame);
+};
+
+#endif
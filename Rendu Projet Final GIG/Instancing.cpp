@@ -0,0 +1,213 @@
+#include "Instancing.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+
+// Structure-of-arrays scratch for the culling pass, reused between frames
+static std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+static std::vector<unsigned char> sphereVisible;
+
+// Scratch for grouping the visible instances by LOD
+static std::vector<InstanceData> lodSorted;
+static std::vector<uint32_t> lodSortedIds;
+static std::vector<unsigned char> visibleLods;
+
+void attachInstanceBuffer(GLuint VAO, GLuint instanceBuffer)
+{
+    glState.bindVertexArray(VAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(offsetof(InstanceData, model) + column * 4 * sizeof(float)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    for (GLuint column = 0; column < 3; column++)
+    {
+        GLuint location = INSTANCE_NORMAL_LOCATION + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void*)(offsetof(InstanceData, normal) + column * 4 * sizeof(float)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+    glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+    glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.bindVertexArray(0);
+}
+
+static void setInstanceModel(InstanceData& instance, const Mat4& model)
+{
+    memcpy(instance.model, model.m, sizeof(instance.model));
+    Mat4 normal = Mat4::normalMatrix(model);
+    memcpy(instance.normal, normal.m, sizeof(instance.normal));
+}
+
+void addInstance(InstancedMesh& mesh, const Mat4& model, float r, float g, float b)
+{
+    InstanceData instance;
+    setInstanceModel(instance, model);
+    instance.color[0] = r;
+    instance.color[1] = g;
+    instance.color[2] = b;
+    instance.color[3] = 1.0f;
+    mesh.instances.push_back(instance);
+    mesh.nodes.push_back(TRANSFORM_ROOT);
+    mesh.instanceLods.push_back(0);
+}
+
+void addInstance(InstancedMesh& mesh, const TransformHierarchy& transforms, int node, float r, float g, float b)
+{
+    addInstance(mesh, transforms.world(node), r, g, b);
+    mesh.nodes.back() = node;
+}
+
+void syncInstanceTransforms(const TransformHierarchy& transforms, InstancedMesh* const* meshes, size_t meshCount)
+{
+    if (transforms.updatedNodes == 0)
+        return;
+
+    for (size_t i = 0; i < meshCount; i++)
+    {
+        InstancedMesh& mesh = *meshes[i];
+        for (size_t j = 0; j < mesh.instances.size(); j++)
+        {
+            int node = mesh.nodes[j];
+            if (node != TRANSFORM_ROOT && transforms.changed(node))
+                setInstanceModel(mesh.instances[j], transforms.world(node));
+        }
+    }
+}
+
+size_t cullInstances(const Frustum& frustum, InstancedMesh* const* meshes, size_t meshCount)
+{
+    sphereX.clear();
+    sphereY.clear();
+    sphereZ.clear();
+    sphereRadius.clear();
+
+    for (size_t i = 0; i < meshCount; i++)
+    {
+        const BoundingSphere& sphere = meshes[i]->range.bounds.sphere;
+        const std::vector<InstanceData>& instances = meshes[i]->instances;
+        for (size_t j = 0; j < instances.size(); j++)
+        {
+            BoundingSphere world = transformSphere(sphere, instances[j].model);
+            sphereX.push_back(world.center.x);
+            sphereY.push_back(world.center.y);
+            sphereZ.push_back(world.center.z);
+            sphereRadius.push_back(world.radius);
+        }
+    }
+
+    sphereVisible.resize(sphereX.size());
+    size_t visibleCount = cullSpheres(frustum, sphereX.data(), sphereY.data(), sphereZ.data(), sphereRadius.data(),
+        sphereX.size(), sphereVisible.data());
+
+    size_t next = 0;
+    for (size_t i = 0; i < meshCount; i++)
+    {
+        InstancedMesh& mesh = *meshes[i];
+        mesh.visible.clear();
+        mesh.visibleIds.clear();
+        for (size_t j = 0; j < mesh.instances.size(); j++, next++)
+        {
+            if (sphereVisible[next])
+            {
+                mesh.visible.push_back(mesh.instances[j]);
+                mesh.visibleIds.push_back((uint32_t)j);
+            }
+        }
+    }
+    return visibleCount;
+}
+
+void selectInstanceLods(const Vector3& eye, float projectionScale, InstancedMesh* const* meshes, size_t meshCount)
+{
+    for (size_t i = 0; i < meshCount; i++)
+    {
+        InstancedMesh& mesh = *meshes[i];
+        if (mesh.lods.empty())
+            continue;
+
+        unsigned int levelCount = (unsigned int)std::min(mesh.lods.size(), (size_t)MAX_LODS);
+        float errors[MAX_LODS];
+        for (unsigned int level = 0; level < levelCount; level++)
+        {
+            errors[level] = mesh.lods[level].error;
+            mesh.lodVisible[level] = 0;
+        }
+
+        // Distance to the instance's bounding sphere, so large objects refine early
+        const BoundingSphere& sphere = mesh.range.bounds.sphere;
+        visibleLods.resize(mesh.visible.size());
+        for (size_t j = 0; j < mesh.visible.size(); j++)
+        {
+            const float* m = mesh.visible[j].model;
+            float scale = maxAxisScale(m);
+            BoundingSphere world = transformSphere(sphere, m);
+            Vector3 toSphere = world.center - eye;
+            float distance = sqrtf(toSphere.x * toSphere.x + toSphere.y * toSphere.y + toSphere.z * toSphere.z) - world.radius;
+
+            uint32_t id = mesh.visibleIds[j];
+            unsigned int level = selectLod(errors, levelCount, scale, distance, projectionScale, mesh.instanceLods[id]);
+            mesh.instanceLods[id] = (unsigned char)level;
+            visibleLods[j] = (unsigned char)level;
+            mesh.lodVisible[level]++;
+        }
+
+        // Counting sort by level keeps each level's instances contiguous
+        GLuint next[MAX_LODS];
+        GLuint first = 0;
+        for (unsigned int level = 0; level < levelCount; level++)
+        {
+            mesh.lodFirst[level] = first;
+            next[level] = first;
+            first += mesh.lodVisible[level];
+        }
+
+        lodSorted.resize(mesh.visible.size());
+        lodSortedIds.resize(mesh.visible.size());
+        for (size_t j = 0; j < mesh.visible.size(); j++)
+        {
+            GLuint slot = next[visibleLods[j]]++;
+            lodSorted[slot] = mesh.visible[j];
+            lodSortedIds[slot] = mesh.visibleIds[j];
+        }
+        mesh.visible.swap(lodSorted);
+        mesh.visibleIds.swap(lodSortedIds);
+    }
+}
+
+bool writeInstances(RingBuffer& ring, InstancedMesh* const* meshes, size_t meshCount)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < meshCount; i++)
+        total += meshes[i]->visible.size();
+
+    RingAllocation allocation = ring.allocate(total * sizeof(InstanceData), sizeof(InstanceData));
+    if (!allocation.data)
+        return false;
+
+    InstanceData* out = (InstanceData*)allocation.data;
+    GLuint baseInstance = (GLuint)(allocation.offset / sizeof(InstanceData));
+    for (size_t i = 0; i < meshCount; i++)
+    {
+        const std::vector<InstanceData>& instances = meshes[i]->visible;
+        meshes[i]->baseInstance = baseInstance;
+        if (!instances.empty())
+            memcpy(out, instances.data(), instances.size() * sizeof(InstanceData));
+        out += instances.size();
+        baseInstance += (GLuint)instances.size();
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+#include "GeometryPool.h"
+#include "Lod.h"
+#include "Mat4.h"
+#include "RingBuffer.h"
+#include "TransformHierarchy.h"
+
+// Per-instance vertex attributes (divisor 1). The model matrix takes four
+// consecutive locations starting at INSTANCE_MODEL_LOCATION, the normal
+// matrix three starting at INSTANCE_NORMAL_LOCATION.
+const GLuint INSTANCE_MODEL_LOCATION = 3;
+const GLuint INSTANCE_NORMAL_LOCATION = 7;
+const GLuint INSTANCE_COLOR_LOCATION = 10;
+
+// The normal matrix is computed once when the instance is added, instead of
+// a mat3(transpose(inverse(model))) per vertex. Its columns are padded to
+// vec4, which keeps the struct at 128 bytes.
+struct InstanceData {
+    float model[16];
+    float normal[12];
+    float color[4];
+};
+
+// A pooled mesh drawn once per visible entry of instances. The visible ones
+// occupy [baseInstance, baseInstance + visible.size()) of the shared instance
+// buffer, which is how each draw of a multi-draw finds its own data.
+//
+// A mesh with lods has its visible instances grouped by level, finest first,
+// by selectInstanceLods; level i draws lodVisible[i] instances starting at
+// baseInstance + lodFirst[i].
+struct InstancedMesh {
+    MeshRange range = {};
+    GLuint baseInstance = 0;
+    std::vector<InstanceData> instances;
+    std::vector<int> nodes;             // Transform of each instance, TRANSFORM_ROOT for fixed ones
+    std::vector<InstanceData> visible;  // Instances that passed this frame's culling
+    std::vector<uint32_t> visibleIds;   // Index in instances of each visible entry
+
+    std::vector<LodLevel> lods;              // Empty: range only. lods[0] should match range
+    std::vector<unsigned char> instanceLods; // Level each instance used last frame
+    GLuint lodFirst[MAX_LODS] = {};
+    GLsizei lodVisible[MAX_LODS] = {};
+};
+
+// Add the per-instance attributes of instanceBuffer to a VAO
+void attachInstanceBuffer(GLuint VAO, GLuint instanceBuffer);
+
+void addInstance(InstancedMesh& mesh, const Mat4& model, float r, float g, float b);
+
+// Instance placed by a node of the hierarchy, kept in sync by syncInstanceTransforms
+void addInstance(InstancedMesh& mesh, const TransformHierarchy& transforms, int node, float r, float g, float b);
+
+// Copy the world matrices the last TransformHierarchy::updateWorld() changed
+// into the instances that use them
+void syncInstanceTransforms(const TransformHierarchy& transforms, InstancedMesh* const* meshes, size_t meshCount);
+
+// Fill each mesh's visible list with the instances whose world-space bounding
+// sphere intersects the frustum. Returns the number of visible instances.
+size_t cullInstances(const Frustum& frustum, InstancedMesh* const* meshes, size_t meshCount);
+
+// Pick a level for every visible instance of the meshes that have lods, from
+// its distance to eye and the world-space error of each level, and group the
+// visible list by level. projectionScale comes from lodProjectionScale().
+void selectInstanceLods(const Vector3& eye, float projectionScale, InstancedMesh* const* meshes, size_t meshCount);
+
+// Stream the visible instances of every mesh into this frame's region of the ring
+// (attached to the VAO at offset 0) and assign each mesh its baseInstance
+bool writeInstances(RingBuffer& ring, InstancedMesh* const* meshes, size_t meshCount);
+
+#endif
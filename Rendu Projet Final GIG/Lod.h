@@ -0,0 +1,48 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <glad/glad.h>
+#include <cmath>
+#include "MeshSimplifier.h"
+
+// Largest geometric error allowed on screen, in pixels
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// A coarser level is only taken once its projected error is this much below
+// the threshold, so objects near a switching distance do not flicker
+const float LOD_HYSTERESIS = 0.25f;
+
+// One detail level: an index range and its geometric error in local units.
+// Levels are ordered finest first and errors never decrease.
+struct LodLevel {
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLsizei indexCount;
+    float error;
+};
+
+// Pixels covered by one unit at distance one, for a vertical field of view
+inline float lodProjectionScale(float fovY, float viewportHeight)
+{
+    return viewportHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+// Coarsest level whose error, scaled to world units by errorScale and
+// projected at distance, stays under LOD_PIXEL_ERROR. current is the level
+// picked last frame, which applies the hysteresis.
+inline unsigned int selectLod(const float* errors, unsigned int levelCount, float errorScale, float distance,
+    float projectionScale, unsigned int current)
+{
+    float pixelsPerUnit = errorScale * projectionScale / fmaxf(distance, 1e-3f);
+    unsigned int level = 0;
+    for (unsigned int i = 1; i < levelCount; i++)
+    {
+        float limit = (i > current) ? LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS) : LOD_PIXEL_ERROR;
+        if (errors[i] * pixelsPerUnit > limit)
+            break;
+        level = i;
+    }
+    return level;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file
+struct MappedFile {
+    const unsigned char* data = NULL;
+    size_t size = 0;
+
+    bool open(const char* path);
+    void close();
+
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+private:
+#ifdef _WIN32
+    void* file = NULL;
+    void* mapping = NULL;
+#endif
+};
+
+#endif
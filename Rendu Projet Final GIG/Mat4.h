@@ -1,23 +1,39 @@
 #ifndef MAT4_H
 #define MAT4_H
 
-#include <cmath>
+#include "ConstMath.h"
+#include "Quat.h"
+#include "Vector3.h"
+#include "Vector4.h"
 
+// SIMD paths for the products. AVX does two result columns per instruction;
+// SSE (always present on x64) one
+#if defined(__AVX__)
+#define MAT4_AVX 1
+#define MAT4_SSE 1
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MAT4_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// Everything except the SIMD products is constexpr, so fixed transforms can
+// be folded at compile time (see ConstMath.h for the trig)
 struct Mat4
 {
     float m[16];
 
-    static Mat4 identity()
+    static constexpr Mat4 identity()
     {
         Mat4 result = {};
         result.m[0] = 1.0f; result.m[5] = 1.0f; result.m[10] = 1.0f; result.m[15] = 1.0f;
         return result;
     }
 
-    static Mat4 perspective(float fov, float aspect, float near, float far)
+    static constexpr Mat4 perspective(float fov, float aspect, float near, float far)
     {
         Mat4 result = {};
-        float tanHalfFov = tanf(fov * 0.5f);
+        float tanHalfFov = constTan(fov * 0.5f);
         result.m[0] = 1.0f / (aspect * tanHalfFov);
         result.m[5] = 1.0f / tanHalfFov;
         result.m[10] = -(far + near) / (far - near);
@@ -26,14 +42,14 @@ struct Mat4
         return result;
     }
 
-    static Mat4 lookAt(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ, float upX, float upY, float upZ)
+    static constexpr Mat4 lookAt(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ, float upX, float upY, float upZ)
     {
         float fx = centerX - eyeX, fy = centerY - eyeY, fz = centerZ - eyeZ;
-        float rlf = 1.0f / sqrtf(fx * fx + fy * fy + fz * fz);
+        float rlf = 1.0f / constSqrt(fx * fx + fy * fy + fz * fz);
         fx *= rlf; fy *= rlf; fz *= rlf;
 
         float sx = upY * fz - upZ * fy, sy = upZ * fx - upX * fz, sz = upX * fy - upY * fx;
-        float rls = 1.0f / sqrtf(sx * sx + sy * sy + sz * sz);
+        float rls = 1.0f / constSqrt(sx * sx + sy * sy + sz * sz);
         sx *= rls; sy *= rls; sz *= rls;
 
         float ux = fy * sz - fz * sy, uy = fz * sx - fx * sz, uz = fx * sy - fy * sx;
@@ -48,55 +64,289 @@ struct Mat4
         return result;
     }
 
-    static Mat4 translate(const Mat4& mat, float x, float y, float z)
+    // The transforms below compose: mat * T, mat * R or mat * S, so the new
+    // transform applies to the object before the ones already in mat
+
+    static constexpr Mat4 translate(const Mat4& mat, float x, float y, float z)
     {
         Mat4 result = mat;
-        result.m[12] += x;
-        result.m[13] += y;
-        result.m[14] += z;
+        for (int row = 0; row < 4; row++)
+            result.m[12 + row] = mat.m[row] * x + mat.m[4 + row] * y + mat.m[8 + row] * z + mat.m[12 + row];
         return result;
     }
 
-    static Mat4 rotateX(const Mat4& mat, float angle)
+    static constexpr Mat4 rotateX(const Mat4& mat, float angle)
     {
         Mat4 result = mat;
-        float c = cosf(angle);
-        float s = sinf(angle);
-        result.m[5] = c; result.m[6] = -s;
-        result.m[9] = s; result.m[10] = c;
+        float c = constCos(angle);
+        float s = constSin(angle);
+        for (int row = 0; row < 4; row++)
+        {
+            result.m[4 + row] = mat.m[4 + row] * c + mat.m[8 + row] * s;
+            result.m[8 + row] = mat.m[8 + row] * c - mat.m[4 + row] * s;
+        }
         return result;
     }
 
-    static Mat4 rotateY(const Mat4& mat, float angle)
+    static constexpr Mat4 rotateY(const Mat4& mat, float angle)
     {
         Mat4 result = mat;
-        float c = cosf(angle);
-        float s = sinf(angle);
-        result.m[0] = c; result.m[2] = s;
-        result.m[8] = -s; result.m[10] = c;
+        float c = constCos(angle);
+        float s = constSin(angle);
+        for (int row = 0; row < 4; row++)
+        {
+            result.m[row] = mat.m[row] * c - mat.m[8 + row] * s;
+            result.m[8 + row] = mat.m[row] * s + mat.m[8 + row] * c;
+        }
         return result;
     }
 
-    static Mat4 rotateZ(const Mat4& mat, float angle)
+    static constexpr Mat4 rotateZ(const Mat4& mat, float angle)
     {
         Mat4 result = mat;
-        float c = cosf(angle);
-        float s = sinf(angle);
-        result.m[0] = c; result.m[1] = -s;
-        result.m[4] = s; result.m[5] = c;
+        float c = constCos(angle);
+        float s = constSin(angle);
+        for (int row = 0; row < 4; row++)
+        {
+            result.m[row] = mat.m[row] * c + mat.m[4 + row] * s;
+            result.m[4 + row] = mat.m[4 + row] * c - mat.m[row] * s;
+        }
         return result;
     }
 
-    static Mat4 scale(const Mat4& mat, float sx, float sy, float sz)
+    static constexpr Mat4 scale(const Mat4& mat, float sx, float sy, float sz)
     {
         Mat4 result = mat;
-        result.m[0] *= sx;
-        result.m[5] *= sy;
-        result.m[10] *= sz;
+        for (int row = 0; row < 4; row++)
+        {
+            result.m[row] *= sx;
+            result.m[4 + row] *= sy;
+            result.m[8 + row] *= sz;
+        }
+        return result;
+    }
+
+    // T * R * S in one step. rotation holds Euler angles in radians, applied
+    // X first, then Y, then Z (R = Rz * Ry * Rx)
+    static constexpr Mat4 trs(const Vector3& translation, const Vector3& rotation, const Vector3& scaling)
+    {
+        float cx = constCos(rotation.x), sx = constSin(rotation.x);
+        float cy = constCos(rotation.y), sy = constSin(rotation.y);
+        float cz = constCos(rotation.z), sz = constSin(rotation.z);
+
+        Mat4 result = {};
+        result.m[0] = cz * cy * scaling.x;
+        result.m[1] = sz * cy * scaling.x;
+        result.m[2] = -sy * scaling.x;
+        result.m[3] = 0.0f;
+        result.m[4] = (cz * sy * sx - sz * cx) * scaling.y;
+        result.m[5] = (sz * sy * sx + cz * cx) * scaling.y;
+        result.m[6] = cy * sx * scaling.y;
+        result.m[7] = 0.0f;
+        result.m[8] = (cz * sy * cx + sz * sx) * scaling.z;
+        result.m[9] = (sz * sy * cx - cz * sx) * scaling.z;
+        result.m[10] = cy * cx * scaling.z;
+        result.m[11] = 0.0f;
+        result.m[12] = translation.x;
+        result.m[13] = translation.y;
+        result.m[14] = translation.z;
+        result.m[15] = 1.0f;
+        return result;
+    }
+
+    // T * R * S with a unit quaternion rotation
+    static constexpr Mat4 trs(const Vector3& translation, const Quat& rotation, const Vector3& scaling)
+    {
+        float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        Mat4 result = {};
+        result.m[0] = (1.0f - 2.0f * (yy + zz)) * scaling.x;
+        result.m[1] = 2.0f * (xy + wz) * scaling.x;
+        result.m[2] = 2.0f * (xz - wy) * scaling.x;
+        result.m[3] = 0.0f;
+        result.m[4] = 2.0f * (xy - wz) * scaling.y;
+        result.m[5] = (1.0f - 2.0f * (xx + zz)) * scaling.y;
+        result.m[6] = 2.0f * (yz + wx) * scaling.y;
+        result.m[7] = 0.0f;
+        result.m[8] = 2.0f * (xz + wy) * scaling.z;
+        result.m[9] = 2.0f * (yz - wx) * scaling.z;
+        result.m[10] = (1.0f - 2.0f * (xx + yy)) * scaling.z;
+        result.m[11] = 0.0f;
+        result.m[12] = translation.x;
+        result.m[13] = translation.y;
+        result.m[14] = translation.z;
+        result.m[15] = 1.0f;
         return result;
     }
 
+    // a * b, column-major like the rest of Mat4. Scalar reference for operator*
+    static constexpr Mat4 multiply(const Mat4& a, const Mat4& b)
+    {
+        Mat4 result = {};
+        for (int col = 0; col < 4; col++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                result.m[col * 4 + row] = a.m[row] * b.m[col * 4] + a.m[4 + row] * b.m[col * 4 + 1]
+                    + a.m[8 + row] * b.m[col * 4 + 2] + a.m[12 + row] * b.m[col * 4 + 3];
+            }
+        }
+        return result;
+    }
+
+    // Each result column is a linear combination of this matrix's columns
+    Mat4 operator*(const Mat4& b) const
+    {
+        Mat4 result;
+#if defined(MAT4_AVX)
+        // Both 128-bit lanes hold the same column of a; each lane of b holds one column
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)&m[0]);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)&m[4]);
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)&m[8]);
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)&m[12]);
+        for (int col = 0; col < 16; col += 8)
+        {
+            __m256 bc = _mm256_loadu_ps(&b.m[col]);
+            __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bc, 0x00));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_permute_ps(bc, 0x55)));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_permute_ps(bc, 0xAA)));
+            r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_permute_ps(bc, 0xFF)));
+            _mm256_storeu_ps(&result.m[col], r);
+        }
+#elif defined(MAT4_SSE)
+        __m128 a0 = _mm_loadu_ps(&m[0]);
+        __m128 a1 = _mm_loadu_ps(&m[4]);
+        __m128 a2 = _mm_loadu_ps(&m[8]);
+        __m128 a3 = _mm_loadu_ps(&m[12]);
+        for (int col = 0; col < 16; col += 4)
+        {
+            __m128 bc = _mm_loadu_ps(&b.m[col]);
+            __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55)));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xAA)));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xFF)));
+            _mm_storeu_ps(&result.m[col], r);
+        }
+#else
+        result = multiply(*this, b);
+#endif
+        return result;
+    }
 
+    Vector4 operator*(const Vector4& v) const
+    {
+#if defined(MAT4_SSE)
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(&m[0]), _mm_set1_ps(v.x));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[4]), _mm_set1_ps(v.y)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[8]), _mm_set1_ps(v.z)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(v.w)));
+        Vector4 result;
+        _mm_storeu_ps(&result.x, r);
+        return result;
+#else
+        return Vector4(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+            m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+            m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+            m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w);
+#endif
+    }
+
+    // Inverse of a matrix whose last row is (0, 0, 0, 1): the 3x3 part is
+    // inverted through cross products (any scale), the translation is -A^-1 * t
+    static constexpr Mat4 affineInverse(const Mat4& mat)
+    {
+        const float* a = mat.m;
+        // Rows of the inverse 3x3 are the cross products of the columns
+        float r0[3] = { a[5] * a[10] - a[6] * a[9], a[6] * a[8] - a[4] * a[10], a[4] * a[9] - a[5] * a[8] };
+        float r1[3] = { a[9] * a[2] - a[10] * a[1], a[10] * a[0] - a[8] * a[2], a[8] * a[1] - a[9] * a[0] };
+        float r2[3] = { a[1] * a[6] - a[2] * a[5], a[2] * a[4] - a[0] * a[6], a[0] * a[5] - a[1] * a[4] };
+        float invDet = 1.0f / (a[0] * r0[0] + a[1] * r0[1] + a[2] * r0[2]);
+
+        Mat4 result = {};
+        for (int col = 0; col < 3; col++)
+        {
+            result.m[col * 4] = r0[col] * invDet;
+            result.m[col * 4 + 1] = r1[col] * invDet;
+            result.m[col * 4 + 2] = r2[col] * invDet;
+            result.m[col * 4 + 3] = 0.0f;
+        }
+        for (int row = 0; row < 3; row++)
+            result.m[12 + row] = -(result.m[row] * a[12] + result.m[4 + row] * a[13] + result.m[8 + row] * a[14]);
+        result.m[15] = 1.0f;
+        return result;
+    }
+
+    // Inverse transpose of the upper 3x3, for transforming normals; the rest
+    // of the result is identity. A rotation with uniform scale s (rigid when
+    // s = 1) skips the inverse: (sR)^-T = R / s = (sR) / s^2
+    static constexpr Mat4 normalMatrix(const Mat4& mat)
+    {
+        const float* a = mat.m;
+        float xx = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+        float yy = a[4] * a[4] + a[5] * a[5] + a[6] * a[6];
+        float zz = a[8] * a[8] + a[9] * a[9] + a[10] * a[10];
+        float xy = a[0] * a[4] + a[1] * a[5] + a[2] * a[6];
+        float xz = a[0] * a[8] + a[1] * a[9] + a[2] * a[10];
+        float yz = a[4] * a[8] + a[5] * a[9] + a[6] * a[10];
+        float tolerance = 1e-4f * xx;
+
+        Mat4 result = identity();
+        if (constAbs(xx - yy) <= tolerance && constAbs(xx - zz) <= tolerance
+            && constAbs(xy) <= tolerance && constAbs(xz) <= tolerance && constAbs(yz) <= tolerance)
+        {
+            float invScale2 = 1.0f / xx;
+            for (int col = 0; col < 3; col++)
+            {
+                for (int row = 0; row < 3; row++)
+                    result.m[col * 4 + row] = a[col * 4 + row] * invScale2;
+            }
+            return result;
+        }
+
+        Mat4 inverse = affineInverse(mat);
+        for (int col = 0; col < 3; col++)
+        {
+            for (int row = 0; row < 3; row++)
+                result.m[col * 4 + row] = inverse.m[row * 4 + col];
+        }
+        return result;
+    }
+
+    // General inverse by cofactor expansion. Returns false and leaves result
+    // untouched when the matrix is singular
+    static constexpr bool invert(const Mat4& mat, Mat4& result)
+    {
+        const float* a = mat.m;
+        float inv[16] = {};
+        inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+        inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+        inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+        inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+        inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+        inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+        inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+        inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+        inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+        inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+        inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+        inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+        inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+        inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+        inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+        inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+        float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+        if (det == 0.0f)
+            return false;
+
+        float invDet = 1.0f / det;
+        for (int i = 0; i < 16; i++)
+            result.m[i] = inv[i] * invDet;
+        return true;
+    }
 };
 
 #endif // MAT4_H
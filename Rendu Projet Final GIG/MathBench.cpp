@@ -0,0 +1,307 @@
+#include "MathBench.h"
+#include "Mat4.h"
+#include "SimdMath.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+const int BENCH_MATRICES = 1024;
+const int BENCH_ROUNDS = 2000;
+const float BENCH_EPSILON = 1e-4f;
+const size_t BENCH_POINTS = 1 << 20;
+const int BENCH_POINT_ROUNDS = 20;
+const float BENCH_INVERSE_EPSILON = 1e-3f;  // Cofactor inverse of a projective matrix loses a few more bits
+
+// Fixed transforms must fold at compile time
+static_assert(Mat4::translate(Mat4::identity(), 1.0f, 2.0f, 3.0f).m[13] == 2.0f, "constexpr translate");
+static_assert(constAbs(Mat4::rotateZ(Mat4::identity(), (float)CONST_PI * 0.5f).m[1] - 1.0f) < 1e-6f, "constexpr rotateZ");
+static_assert(constAbs(constSqrt(2.0f) - 1.41421356f) < 1e-6f, "constexpr sqrt");
+
+static float randomFloat(float low, float high)
+{
+    return low + (high - low) * (float)rand() / (float)RAND_MAX;
+}
+
+static Mat4 randomTransform()
+{
+    Vector3 translation(randomFloat(-10.0f, 10.0f), randomFloat(-10.0f, 10.0f), randomFloat(-10.0f, 10.0f));
+    Vector3 rotation(randomFloat(-3.14f, 3.14f), randomFloat(-3.14f, 3.14f), randomFloat(-3.14f, 3.14f));
+    Vector3 scaling(randomFloat(0.5f, 2.0f), randomFloat(0.5f, 2.0f), randomFloat(0.5f, 2.0f));
+    return Mat4::trs(translation, rotation, scaling);
+}
+
+// Largest absolute difference between two matrices, relative to their magnitude
+static float maxError(const Mat4& a, const Mat4& b)
+{
+    float error = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float diff = fabsf(a.m[i] - b.m[i]) / (1.0f + fabsf(b.m[i]));
+        error = diff > error ? diff : error;
+    }
+    return error;
+}
+
+static bool report(const char* name, float error, float epsilon)
+{
+    bool pass = error <= epsilon;
+    std::cout << "  " << name << ": max error " << error << (pass ? "" : "  FAILED") << std::endl;
+    return pass;
+}
+
+static double nanosecondsPerOp(std::chrono::high_resolution_clock::time_point start, long long ops)
+{
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / (double)ops;
+}
+
+int runMat4Benchmark()
+{
+    srand(1234);
+    std::vector<Mat4> a(BENCH_MATRICES), b(BENCH_MATRICES), out(BENCH_MATRICES);
+    for (int i = 0; i < BENCH_MATRICES; i++)
+    {
+        a[i] = randomTransform();
+        b[i] = randomTransform();
+        // Perspective-like last rows exercise the full 4x4 product
+        b[i].m[3] = randomFloat(-0.5f, 0.5f);
+        b[i].m[11] = randomFloat(-0.5f, 0.5f);
+    }
+
+#if defined(MAT4_AVX)
+    std::cout << "Mat4 path: AVX" << std::endl;
+#elif defined(MAT4_SSE)
+    std::cout << "Mat4 path: SSE" << std::endl;
+#else
+    std::cout << "Mat4 path: scalar" << std::endl;
+#endif
+
+    // constexpr trig and sqrt against <cmath>
+    float constError = 0.0f;
+    for (int i = -2000; i <= 2000; i++)
+    {
+        float angle = i * 0.01f;
+        float e = fabsf(constSin(angle) - sinf(angle)) + fabsf(constCos(angle) - cosf(angle));
+        e = fmaxf(e, fabsf(constTan(angle * 0.1f) - tanf(angle * 0.1f)));
+        e = fmaxf(e, fabsf(constSqrt(fabsf(angle)) - sqrtf(fabsf(angle))));
+        constError = e > constError ? e : constError;
+    }
+
+    // Correctness against the scalar reference
+    float multiplyError = 0.0f, vectorError = 0.0f, trsError = 0.0f, affineError = 0.0f, inverseError = 0.0f, normalError = 0.0f;
+    Mat4 identity = Mat4::identity();
+    for (int i = 0; i < BENCH_MATRICES; i++)
+    {
+        float e = maxError(a[i] * b[i], Mat4::multiply(a[i], b[i]));
+        multiplyError = e > multiplyError ? e : multiplyError;
+
+        // A vector is the first column of an otherwise empty matrix
+        Mat4 column = {};
+        column.m[0] = b[i].m[12]; column.m[1] = b[i].m[13]; column.m[2] = b[i].m[14]; column.m[3] = 1.0f;
+        Vector4 v = a[i] * Vector4(column.m[0], column.m[1], column.m[2], column.m[3]);
+        Mat4 product = {};
+        product.m[0] = v.x; product.m[1] = v.y; product.m[2] = v.z; product.m[3] = v.w;
+        e = maxError(product, Mat4::multiply(a[i], column));
+        vectorError = e > vectorError ? e : vectorError;
+
+        Vector3 t(1.0f, -2.0f, 3.0f), r(0.3f * i, -0.2f * i, 0.1f * i), s(1.5f, 0.5f, 2.0f);
+        Mat4 composed = Mat4::scale(Mat4::rotateX(Mat4::rotateY(Mat4::rotateZ(Mat4::translate(identity, t.x, t.y, t.z), r.z), r.y), r.x), s.x, s.y, s.z);
+        e = maxError(Mat4::trs(t, r, s), composed);
+        trsError = e > trsError ? e : trsError;
+
+        e = maxError(Mat4::multiply(a[i], Mat4::affineInverse(a[i])), identity);
+        affineError = e > affineError ? e : affineError;
+
+        // Normal matrix against the transposed general inverse, for the
+        // non-uniform scale path and the rotation with uniform scale path
+        Mat4 rigid = Mat4::trs(t, r, Vector3(s.x, s.x, s.x));
+        const Mat4* transforms[2] = { &a[i], &rigid };
+        for (int j = 0; j < 2; j++)
+        {
+            Mat4 inverse, expected = Mat4::identity();
+            Mat4::invert(*transforms[j], inverse);
+            for (int col = 0; col < 3; col++)
+            {
+                for (int row = 0; row < 3; row++)
+                    expected.m[col * 4 + row] = inverse.m[row * 4 + col];
+            }
+            e = maxError(Mat4::normalMatrix(*transforms[j]), expected);
+            normalError = e > normalError ? e : normalError;
+        }
+
+        Mat4 inverse;
+        if (Mat4::invert(b[i], inverse))
+        {
+            e = maxError(Mat4::multiply(b[i], inverse), identity);
+            inverseError = e > inverseError ? e : inverseError;
+        }
+    }
+
+    bool pass = true;
+    std::cout << "Correctness" << std::endl;
+    pass &= report("constexpr sin/cos/tan/sqrt", constError, BENCH_EPSILON);
+    pass &= report("operator* vs scalar multiply", multiplyError, BENCH_EPSILON);
+    pass &= report("Mat4 * Vector4", vectorError, BENCH_EPSILON);
+    pass &= report("trs vs composed transforms", trsError, BENCH_EPSILON);
+    pass &= report("affineInverse", affineError, BENCH_EPSILON);
+    pass &= report("invert", inverseError, BENCH_INVERSE_EPSILON);
+    pass &= report("normalMatrix", normalError, BENCH_EPSILON);
+
+    // Throughput; the checksum keeps the loops from being optimized away
+    const long long ops = (long long)BENCH_MATRICES * BENCH_ROUNDS;
+    float checksum = 0.0f;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int i = 0; i < BENCH_MATRICES; i++)
+            out[i] = Mat4::multiply(a[i], b[i]);
+        checksum += out[round % BENCH_MATRICES].m[round % 16];
+    }
+    double scalarNs = nanosecondsPerOp(start, ops);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int i = 0; i < BENCH_MATRICES; i++)
+            out[i] = a[i] * b[i];
+        checksum += out[round % BENCH_MATRICES].m[round % 16];
+    }
+    double simdNs = nanosecondsPerOp(start, ops);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int i = 0; i < BENCH_MATRICES; i++)
+            out[i] = Mat4::affineInverse(a[i]);
+        checksum += out[round % BENCH_MATRICES].m[round % 16];
+    }
+    double affineNs = nanosecondsPerOp(start, ops);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int i = 0; i < BENCH_MATRICES; i++)
+            Mat4::invert(b[i], out[i]);
+        checksum += out[round % BENCH_MATRICES].m[round % 16];
+    }
+    double inverseNs = nanosecondsPerOp(start, ops);
+
+    std::cout << "Throughput (" << ops << " ops each)" << std::endl;
+    std::cout << "  scalar multiply: " << scalarNs << " ns, " << 1000.0 / scalarNs << " M/s" << std::endl;
+    std::cout << "  operator*:       " << simdNs << " ns, " << 1000.0 / simdNs << " M/s" << std::endl;
+    std::cout << "  affineInverse:   " << affineNs << " ns, " << 1000.0 / affineNs << " M/s" << std::endl;
+    std::cout << "  invert:          " << inverseNs << " ns, " << 1000.0 / inverseNs << " M/s" << std::endl;
+    std::cout << "  (checksum " << checksum << ")" << std::endl;
+
+    return pass ? 0 : 1;
+}
+
+// Largest relative difference between two float arrays
+static float maxArrayError(const float* a, const float* b, size_t count)
+{
+    float error = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        float diff = fabsf(a[i] - b[i]) / (1.0f + fabsf(b[i]));
+        error = diff > error ? diff : error;
+    }
+    return error;
+}
+
+static float maxSoaError(Vec3Soa a, Vec3Soa b, size_t count)
+{
+    float error = maxArrayError(a.x, b.x, count);
+    float e = maxArrayError(a.y, b.y, count);
+    error = e > error ? e : error;
+    e = maxArrayError(a.z, b.z, count);
+    return e > error ? e : error;
+}
+
+int runSimdBenchmark()
+{
+    // Odd count so every kernel also runs its remainder path
+    const size_t count = BENCH_POINTS + 13;
+    srand(1234);
+    std::vector<float> data(count * 12);
+    for (size_t i = 0; i < count * 6; i++)
+        data[i] = randomFloat(-10.0f, 10.0f);
+    data[0] = data[count] = data[count * 2] = 0.0f;  // A zero vector must normalize to zero
+
+    Vec3Soa a = { &data[0], &data[count], &data[count * 2] };
+    Vec3Soa b = { &data[count * 3], &data[count * 4], &data[count * 5] };
+    Vec3Soa expected = { &data[count * 6], &data[count * 7], &data[count * 8] };
+    Vec3Soa result = { &data[count * 9], &data[count * 10], &data[count * 11] };
+    std::vector<float> expectedDot(count), resultDot(count);
+
+    Mat4 m = randomTransform();
+    const SimdKernels& scalar = SIMD_KERNELS_SCALAR;
+    std::cout << "Detected SIMD level: " << simdKernels().name << std::endl;
+
+    bool pass = true;
+    double scalarNs = 0.0;
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; level++)
+    {
+        const SimdKernels* kernels = simdKernelsFor((SimdLevel)level);
+        if (!kernels)
+            continue;
+
+        // Correctness against the scalar kernels
+        scalar.transformPoints(m, a, expected, count);
+        kernels->transformPoints(m, a, result, count);
+        float transformError = maxSoaError(result, expected, count);
+
+        scalar.dot(a, b, expectedDot.data(), count);
+        kernels->dot(a, b, resultDot.data(), count);
+        float dotError = maxArrayError(resultDot.data(), expectedDot.data(), count);
+
+        scalar.cross(a, b, expected, count);
+        kernels->cross(a, b, result, count);
+        float crossError = maxSoaError(result, expected, count);
+
+        scalar.transformPoints(m, a, expected, count);  // Copies to normalize in place
+        kernels->transformPoints(m, a, result, count);
+        scalar.normalize(expected, count);
+        kernels->normalize(result, count);
+        float normalizeError = maxSoaError(result, expected, count);
+
+        std::cout << kernels->name << std::endl;
+        pass &= report("transformPoints", transformError, BENCH_EPSILON);
+        pass &= report("dot", dotError, BENCH_EPSILON);
+        pass &= report("cross", crossError, BENCH_EPSILON);
+        pass &= report("normalize", normalizeError, BENCH_EPSILON);
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < BENCH_POINT_ROUNDS; round++)
+            kernels->transformPoints(m, a, result, count);
+        double ns = nanosecondsPerOp(start, (long long)count * BENCH_POINT_ROUNDS);
+        if (level == SIMD_SCALAR)
+            scalarNs = ns;
+        std::cout << "  transformPoints: " << ns << " ns/point, " << 1000.0 / ns << " Mpoints/s, "
+            << scalarNs / ns << "x scalar" << std::endl;
+    }
+
+    // AoS entry point, through the dispatched kernels
+    std::vector<Vector3> points(count), transformed(count);
+    for (size_t i = 0; i < count; i++)
+        points[i] = Vector3(a.x[i], a.y[i], a.z[i]);
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < BENCH_POINT_ROUNDS; round++)
+        transformPoints(m, points.data(), transformed.data(), count);
+    double aosNs = nanosecondsPerOp(start, (long long)count * BENCH_POINT_ROUNDS);
+
+    scalar.transformPoints(m, a, expected, count);
+    float aosError = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        float e = fabsf(transformed[i].x - expected.x[i]) + fabsf(transformed[i].y - expected.y[i]) + fabsf(transformed[i].z - expected.z[i]);
+        aosError = e > aosError ? e : aosError;
+    }
+    std::cout << "AoS Vector3 array" << std::endl;
+    pass &= report("transformPoints", aosError, BENCH_EPSILON * 10.0f);
+    std::cout << "  transformPoints: " << aosNs << " ns/point, " << 1000.0 / aosNs << " Mpoints/s" << std::endl;
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#ifndef MATHBENCH_H
+#define MATHBENCH_H
+
+// Check the SIMD Mat4 paths against the scalar reference and time them.
+// Returns 0 when every result is within epsilon, 1 otherwise.
+int runMat4Benchmark();
+
+// Run every SoA batch kernel this CPU supports against the scalar ones and
+// time them. Returns 0 when every result is within epsilon, 1 otherwise.
+int runSimdBenchmark();
+
+#endif
@@ -0,0 +1,432 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+const size_t MESH_CACHE_NAME_LENGTH = 64;
+const size_t MESH_CACHE_PATH_LENGTH = 256;
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t vertexFloats;
+    uint32_t submeshCount;
+    uint32_t nodeCount;
+    uint32_t materialCount;
+    uint32_t meshletCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t submeshOffset;
+    uint64_t nodeOffset;
+    uint64_t materialOffset;
+    uint64_t meshletOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+};
+
+struct CachedLod {
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    int32_t indexCount;
+    float error;
+};
+
+struct CachedSubmesh {
+    int32_t baseVertex;
+    uint32_t firstIndex;
+    int32_t indexCount;
+    uint32_t materialId;
+    int32_t node;
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+    uint32_t lodCount;
+    CachedLod lods[MAX_LODS];
+    uint32_t firstMeshlet;
+    uint32_t meshletCount;
+};
+
+struct CachedMeshlet {
+    uint32_t firstIndex;
+    int32_t indexCount;
+    float sphereCenter[3];
+    float sphereRadius;
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+struct CachedNode {
+    char name[MESH_CACHE_NAME_LENGTH];
+    int32_t parent;
+    float local[16];
+    float world[16];
+};
+
+struct CachedMaterial {
+    char name[MESH_CACHE_NAME_LENGTH];
+    float diffuse[4];
+    char diffuseTexture[MESH_CACHE_PATH_LENGTH];
+};
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+static void copyName(char* out, size_t outSize, const std::string& name)
+{
+    memset(out, 0, outSize);
+    strncpy(out, name.c_str(), outSize - 1);
+}
+
+// Fixed-size, possibly unterminated string field
+static std::string readName(const char* name, size_t size)
+{
+    const char* end = (const char*)memchr(name, 0, size);
+    return std::string(name, end ? (size_t)(end - name) : size);
+}
+
+static void writeBounds(const Bounds& bounds, float* min, float* max, float* center, float& radius)
+{
+    min[0] = bounds.box.min.x; min[1] = bounds.box.min.y; min[2] = bounds.box.min.z;
+    max[0] = bounds.box.max.x; max[1] = bounds.box.max.y; max[2] = bounds.box.max.z;
+    center[0] = bounds.sphere.center.x; center[1] = bounds.sphere.center.y; center[2] = bounds.sphere.center.z;
+    radius = bounds.sphere.radius;
+}
+
+static Bounds readBounds(const float* min, const float* max, const float* center, float radius)
+{
+    Bounds bounds;
+    bounds.box.min = Vector3(min[0], min[1], min[2]);
+    bounds.box.max = Vector3(max[0], max[1], max[2]);
+    bounds.sphere.center = Vector3(center[0], center[1], center[2]);
+    bounds.sphere.radius = radius;
+    return bounds;
+}
+
+bool meshCacheKey(const std::string& sourcePath, unsigned int importFlags, unsigned int options, uint64_t& key)
+{
+    MappedFile source;
+    if (!source.open(sourcePath.c_str()))
+        return false;
+
+    uint32_t version = MESH_CACHE_VERSION;
+    key = fnv1a64(source.data, source.size);
+    key = fnv1a64(&importFlags, sizeof(importFlags), key);
+    key = fnv1a64(&options, sizeof(options), key);
+    key = fnv1a64(&version, sizeof(version), key);
+    return true;
+}
+
+std::string meshCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".mesh";
+}
+
+bool writeMeshCache(const std::string& cachePath, uint64_t key, const Mesh& mesh)
+{
+    MeshCacheHeader header = {};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = key;
+    header.vertexFloats = MODEL_VERTEX_FLOATS;
+    header.submeshCount = (uint32_t)mesh.submeshes.size();
+    header.nodeCount = (uint32_t)mesh.nodes.size();
+    header.materialCount = (uint32_t)mesh.materials.size();
+    header.meshletCount = (uint32_t)mesh.meshlets.size();
+    header.vertexCount = mesh.vertices.size() / MODEL_VERTEX_FLOATS;
+    header.indexCount = mesh.indices.size();
+    header.submeshOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.nodeOffset = alignOffset(header.submeshOffset + header.submeshCount * sizeof(CachedSubmesh));
+    header.materialOffset = alignOffset(header.nodeOffset + header.nodeCount * sizeof(CachedNode));
+    header.meshletOffset = alignOffset(header.materialOffset + header.materialCount * sizeof(CachedMaterial));
+    header.vertexOffset = alignOffset(header.meshletOffset + header.meshletCount * sizeof(CachedMeshlet));
+    header.indexOffset = alignOffset(header.vertexOffset + mesh.vertices.size() * sizeof(float));
+    writeBounds(mesh.bounds, header.boundsMin, header.boundsMax, header.sphereCenter, header.sphereRadius);
+
+    std::vector<CachedSubmesh> submeshes(header.submeshCount);
+    for (size_t i = 0; i < submeshes.size(); i++)
+    {
+        const Submesh& source = mesh.submeshes[i];
+        CachedSubmesh& out = submeshes[i];
+        out.baseVertex = source.baseVertex;
+        out.firstIndex = source.firstIndex;
+        out.indexCount = source.indexCount;
+        out.materialId = source.materialId;
+        out.node = source.node;
+        writeBounds(source.bounds, out.boundsMin, out.boundsMax, out.sphereCenter, out.sphereRadius);
+        out.lodCount = source.lodCount;
+        for (unsigned int level = 0; level < MAX_LODS; level++)
+        {
+            out.lods[level].firstIndex = source.lods[level].firstIndex;
+            out.lods[level].baseVertex = source.lods[level].baseVertex;
+            out.lods[level].indexCount = source.lods[level].indexCount;
+            out.lods[level].error = source.lods[level].error;
+        }
+        out.firstMeshlet = source.firstMeshlet;
+        out.meshletCount = source.meshletCount;
+    }
+
+    std::vector<CachedNode> nodes(header.nodeCount);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        copyName(nodes[i].name, sizeof(nodes[i].name), mesh.nodes[i].name);
+        nodes[i].parent = mesh.nodes[i].parent;
+        memcpy(nodes[i].local, mesh.nodes[i].local.m, sizeof(nodes[i].local));
+        memcpy(nodes[i].world, mesh.nodes[i].world.m, sizeof(nodes[i].world));
+    }
+
+    std::vector<CachedMaterial> materials(header.materialCount);
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        copyName(materials[i].name, sizeof(materials[i].name), mesh.materials[i].name);
+        memcpy(materials[i].diffuse, mesh.materials[i].diffuse, sizeof(materials[i].diffuse));
+        copyName(materials[i].diffuseTexture, sizeof(materials[i].diffuseTexture), mesh.materials[i].diffuseTexture);
+    }
+
+    std::vector<CachedMeshlet> meshlets(header.meshletCount);
+    for (size_t i = 0; i < meshlets.size(); i++)
+    {
+        const Meshlet& source = mesh.meshlets[i];
+        meshlets[i].firstIndex = source.firstIndex;
+        meshlets[i].indexCount = source.indexCount;
+        meshlets[i].sphereCenter[0] = source.sphere.center.x;
+        meshlets[i].sphereCenter[1] = source.sphere.center.y;
+        meshlets[i].sphereCenter[2] = source.sphere.center.z;
+        meshlets[i].sphereRadius = source.sphere.radius;
+        meshlets[i].coneAxis[0] = source.coneAxis.x;
+        meshlets[i].coneAxis[1] = source.coneAxis.y;
+        meshlets[i].coneAxis[2] = source.coneAxis.z;
+        meshlets[i].coneCutoff = source.coneCutoff;
+    }
+
+    // Written to a temporary file first so a crash never leaves a torn cache.
+    // Every write gets its own name: loads of one model on several threads
+    // each write the cache, and must not interleave in one file.
+    static std::atomic<unsigned int> tempCounter(0);
+    std::string tempPath = cachePath + "." + std::to_string(tempCounter++) + ".tmp";
+    std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    const char padding[MESH_CACHE_ALIGNMENT] = {};
+    uint64_t written = 0;
+    struct Blob { uint64_t offset; const void* data; size_t size; };
+    Blob blobs[] = {
+        { 0, &header, sizeof(header) },
+        { header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(CachedSubmesh) },
+        { header.nodeOffset, nodes.data(), nodes.size() * sizeof(CachedNode) },
+        { header.materialOffset, materials.data(), materials.size() * sizeof(CachedMaterial) },
+        { header.meshletOffset, meshlets.data(), meshlets.size() * sizeof(CachedMeshlet) },
+        { header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(float) },
+        { header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int) },
+    };
+    for (size_t i = 0; i < sizeof(blobs) / sizeof(blobs[0]); i++)
+    {
+        file.write(padding, (std::streamsize)(blobs[i].offset - written));
+        if (blobs[i].size > 0)
+            file.write((const char*)blobs[i].data, (std::streamsize)blobs[i].size);
+        written = blobs[i].offset + blobs[i].size;
+    }
+    file.close();
+    if (!file)
+    {
+        std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// True if [offset, offset + size) lies inside the file
+static bool inFile(const MappedFile& file, uint64_t offset, uint64_t size)
+{
+    return offset <= file.size && size <= file.size - offset;
+}
+
+// True if indexCount indices from firstIndex, offset by baseVertex, stay
+// inside the cached index and vertex buffers
+static bool inBuffers(const MeshCacheHeader& header, uint32_t firstIndex, int32_t indexCount, int32_t baseVertex)
+{
+    return indexCount >= 0 && (uint64_t)firstIndex + (uint64_t)indexCount <= header.indexCount
+        && baseVertex >= 0 && (uint64_t)baseVertex <= header.vertexCount;
+}
+
+// True if every index of an in-buffer range, offset by baseVertex, names a
+// cached vertex. Nodes sharing a mesh share its ranges, so each range's
+// largest index is found once and kept in largest.
+static bool indicesInVertices(const MeshCacheHeader& header, const unsigned int* indices, uint32_t firstIndex,
+    int32_t indexCount, int32_t baseVertex, std::map<uint64_t, uint32_t>& largest)
+{
+    if (indexCount == 0)
+        return true;
+
+    uint64_t range = ((uint64_t)firstIndex << 32) | (uint32_t)indexCount;
+    std::map<uint64_t, uint32_t>::iterator found = largest.find(range);
+    if (found == largest.end())
+    {
+        uint32_t maxIndex = 0;
+        for (uint64_t i = firstIndex; i < (uint64_t)firstIndex + (uint64_t)indexCount; i++)
+            maxIndex = std::max(maxIndex, (uint32_t)indices[i]);
+        found = largest.insert(std::make_pair(range, maxIndex)).first;
+    }
+    return (uint64_t)found->second + (uint64_t)baseVertex < header.vertexCount;
+}
+
+static bool corrupt(const std::string& cachePath)
+{
+    std::cerr << "Corrupt mesh cache: " << cachePath << std::endl;
+    return false;
+}
+
+bool loadMeshCache(const std::string& cachePath, uint64_t key, Mesh& mesh, bool upload)
+{
+    MappedFile file;
+    if (!file.open(cachePath.c_str()) || file.size < sizeof(MeshCacheHeader))
+        return false;
+
+    MeshCacheHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION
+        || header.sourceHash != key || header.vertexFloats != MODEL_VERTEX_FLOATS)
+        return false;
+
+    // Counts beyond the file size would overflow the byte sizes below
+    if (header.vertexCount > file.size || header.indexCount > file.size)
+        return corrupt(cachePath);
+
+    uint64_t vertexBytes = header.vertexCount * MODEL_VERTEX_FLOATS * sizeof(float);
+    uint64_t indexBytes = header.indexCount * sizeof(unsigned int);
+    if (!inFile(file, header.submeshOffset, header.submeshCount * sizeof(CachedSubmesh))
+        || !inFile(file, header.nodeOffset, header.nodeCount * sizeof(CachedNode))
+        || !inFile(file, header.materialOffset, header.materialCount * sizeof(CachedMaterial))
+        || !inFile(file, header.meshletOffset, header.meshletCount * sizeof(CachedMeshlet))
+        || !inFile(file, header.vertexOffset, vertexBytes)
+        || !inFile(file, header.indexOffset, indexBytes))
+    {
+        std::cerr << "Truncated mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    mesh.bounds = readBounds(header.boundsMin, header.boundsMax, header.sphereCenter, header.sphereRadius);
+
+    const CachedSubmesh* submeshes = (const CachedSubmesh*)(file.data + header.submeshOffset);
+    const CachedMeshlet* meshlets = (const CachedMeshlet*)(file.data + header.meshletOffset);
+    const float* vertices = (const float*)(file.data + header.vertexOffset);
+    const unsigned int* indices = (const unsigned int*)(file.data + header.indexOffset);
+    std::map<uint64_t, uint32_t> largestIndices;
+    mesh.submeshes.resize(header.submeshCount);
+    for (uint32_t i = 0; i < header.submeshCount; i++)
+    {
+        // Every range is drawn as is, so a range outside the buffers, or an
+        // index past the vertices, rejects the file
+        const CachedSubmesh& submesh = submeshes[i];
+        if (!inBuffers(header, submesh.firstIndex, submesh.indexCount, submesh.baseVertex)
+            || !indicesInVertices(header, indices, submesh.firstIndex, submesh.indexCount, submesh.baseVertex, largestIndices)
+            || submesh.node < 0 || (uint32_t)submesh.node >= header.nodeCount
+            || (uint64_t)submesh.firstMeshlet + submesh.meshletCount > header.meshletCount)
+            return corrupt(cachePath);
+        for (unsigned int level = 0; level < std::min(std::max(submesh.lodCount, 1u), MAX_LODS); level++)
+        {
+            const CachedLod& lod = submesh.lods[level];
+            if (!inBuffers(header, lod.firstIndex, lod.indexCount, lod.baseVertex)
+                || !indicesInVertices(header, indices, lod.firstIndex, lod.indexCount, lod.baseVertex, largestIndices))
+                return corrupt(cachePath);
+        }
+
+        // Meshlets are drawn with the submesh's baseVertex, so they must
+        // stay inside its full range
+        for (uint32_t j = submesh.firstMeshlet; j < submesh.firstMeshlet + submesh.meshletCount; j++)
+        {
+            if (meshlets[j].indexCount < 0 || meshlets[j].firstIndex < submesh.firstIndex
+                || (uint64_t)meshlets[j].firstIndex + (uint64_t)meshlets[j].indexCount
+                    > (uint64_t)submesh.firstIndex + (uint64_t)submesh.indexCount)
+                return corrupt(cachePath);
+        }
+
+        Submesh& out = mesh.submeshes[i];
+        out.baseVertex = submeshes[i].baseVertex;
+        out.firstIndex = submeshes[i].firstIndex;
+        out.indexCount = submeshes[i].indexCount;
+        out.materialId = submeshes[i].materialId;
+        out.node = submeshes[i].node;
+        out.bounds = readBounds(submeshes[i].boundsMin, submeshes[i].boundsMax, submeshes[i].sphereCenter, submeshes[i].sphereRadius);
+        out.lodCount = std::min(std::max(submeshes[i].lodCount, 1u), MAX_LODS);
+        for (unsigned int level = 0; level < MAX_LODS; level++)
+        {
+            out.lods[level].firstIndex = submeshes[i].lods[level].firstIndex;
+            out.lods[level].baseVertex = submeshes[i].lods[level].baseVertex;
+            out.lods[level].indexCount = submeshes[i].lods[level].indexCount;
+            out.lods[level].error = submeshes[i].lods[level].error;
+        }
+        out.firstMeshlet = submeshes[i].firstMeshlet;
+        out.meshletCount = submeshes[i].meshletCount;
+    }
+
+    mesh.meshlets.resize(header.meshletCount);
+    for (uint32_t i = 0; i < header.meshletCount; i++)
+    {
+        if (!inBuffers(header, meshlets[i].firstIndex, meshlets[i].indexCount, 0))
+            return corrupt(cachePath);
+
+        Meshlet& out = mesh.meshlets[i];
+        out.firstIndex = meshlets[i].firstIndex;
+        out.indexCount = meshlets[i].indexCount;
+        out.sphere.center = Vector3(meshlets[i].sphereCenter[0], meshlets[i].sphereCenter[1], meshlets[i].sphereCenter[2]);
+        out.sphere.radius = meshlets[i].sphereRadius;
+        out.coneAxis = Vector3(meshlets[i].coneAxis[0], meshlets[i].coneAxis[1], meshlets[i].coneAxis[2]);
+        out.coneCutoff = meshlets[i].coneCutoff;
+    }
+
+    const CachedNode* nodes = (const CachedNode*)(file.data + header.nodeOffset);
+    mesh.nodes.resize(header.nodeCount);
+    for (uint32_t i = 0; i < header.nodeCount; i++)
+    {
+        mesh.nodes[i].name = readName(nodes[i].name, sizeof(nodes[i].name));
+        mesh.nodes[i].parent = nodes[i].parent;
+        memcpy(mesh.nodes[i].local.m, nodes[i].local, sizeof(nodes[i].local));
+        memcpy(mesh.nodes[i].world.m, nodes[i].world, sizeof(nodes[i].world));
+    }
+
+    const CachedMaterial* materials = (const CachedMaterial*)(file.data + header.materialOffset);
+    mesh.materials.resize(header.materialCount);
+    for (uint32_t i = 0; i < header.materialCount; i++)
+    {
+        mesh.materials[i].name = readName(materials[i].name, sizeof(materials[i].name));
+        memcpy(mesh.materials[i].diffuse, materials[i].diffuse, sizeof(materials[i].diffuse));
+        mesh.materials[i].diffuseTexture = readName(materials[i].diffuseTexture, sizeof(materials[i].diffuseTexture));
+    }
+
+    if (!upload)
+    {
+        mesh.vertices.assign(vertices, vertices + header.vertexCount * MODEL_VERTEX_FLOATS);
+        mesh.indices.assign(indices, indices + header.indexCount);
+        return true;
+    }
+
+    // The blobs go to the driver straight from the page cache
+    uploadMesh(mesh, vertices, (size_t)header.vertexCount, indices, (size_t)header.indexCount);
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Hash.h"
+#include "ModelLoader.h"
+
+// Cooked .mesh files: the result of an import, stored next to the source so
+// later runs skip Assimp entirely.
+//
+// Layout (little endian, every blob 64-byte aligned):
+//   MeshCacheHeader
+//   CachedSubmesh[submeshCount]
+//   CachedNode[nodeCount]
+//   CachedMaterial[materialCount]
+//   CachedMeshlet[meshletCount]
+//   vertex blob (vertexCount * MODEL_VERTEX_FLOATS floats), uploaded as is
+//   index blob (indexCount uint32, every submesh's LODs after its full range), uploaded as is
+//
+// A cache is valid only if its sourceHash matches meshCacheKey() of the
+// current source file, import flags and MESH_CACHE_VERSION.
+const uint32_t MESH_CACHE_MAGIC = 0x4853454D;  // "MESH"
+const uint32_t MESH_CACHE_VERSION = 4;         // Bump on any layout or import change (2: optimized meshes, 3: LODs, 4: meshlets)
+const size_t MESH_CACHE_ALIGNMENT = 64;
+
+// Hash of the source file's content, the postprocess flags, the MODEL_OPTION_*
+// bits and the format version. Returns false if the source cannot be read.
+bool meshCacheKey(const std::string& sourcePath, unsigned int importFlags, unsigned int options, uint64_t& key);
+
+std::string meshCachePath(const std::string& sourcePath);
+
+// Write the CPU data of an imported mesh (vertices, indices and tables)
+bool writeMeshCache(const std::string& cachePath, uint64_t key, const Mesh& mesh);
+
+// Map a cache and, if it is valid for key, fill the mesh tables and upload
+// the vertex and index blobs directly from the mapping; mesh.vertices and
+// mesh.indices stay empty. Without upload (no GL, any thread) the blobs are
+// copied into mesh.vertices and mesh.indices instead.
+bool loadMeshCache(const std::string& cachePath, uint64_t key, Mesh& mesh, bool upload = true);
+
+#endif
@@ -0,0 +1,353 @@
+#include "MeshOptimizer.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Forsyth scoring parameters, from "Linear-Speed Vertex Cache Optimisation"
+const int FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+void VertexCacheStats::add(const VertexCacheStats& other)
+{
+    triangles += other.triangles;
+    vertices += other.vertices;
+    misses += other.misses;
+}
+
+void MeshOptimizeStats::add(const MeshOptimizeStats& other)
+{
+    verticesBefore += other.verticesBefore;
+    verticesAfter += other.verticesAfter;
+    before.add(other.before);
+    after.add(other.after);
+}
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    stats.triangles = indexCount / 3;
+
+    // FIFO: a vertex is cached if it entered fewer than cacheSize misses ago
+    std::vector<size_t> enteredAt(vertexCount, 0);
+    std::vector<unsigned char> seen(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int v = indices[i];
+        if (!seen[v])
+        {
+            seen[v] = 1;
+            stats.vertices++;
+        }
+        else if (stats.misses - enteredAt[v] < cacheSize)
+        {
+            continue;
+        }
+        enteredAt[v] = stats.misses;
+        stats.misses++;
+    }
+    return stats;
+}
+
+void weldVertices(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices)
+{
+    size_t vertexCount = vertices.size() / stride;
+    size_t bytes = stride * sizeof(float);
+
+    // Open addressing, power of two table at most half full
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<unsigned int> table(tableSize, ~0u);
+
+    std::vector<unsigned int> remap(vertexCount);
+    size_t unique = 0;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* vertex = &vertices[i * stride];
+        size_t slot = (size_t)fnv1a64(vertex, bytes) & (tableSize - 1);
+        while (table[slot] != ~0u && memcmp(&vertices[table[slot] * stride], vertex, bytes) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == ~0u)
+        {
+            // First occurrence: compact it down to the next unique slot
+            if (unique != i)
+                memmove(&vertices[unique * stride], vertex, bytes);
+            table[slot] = (unsigned int)unique;
+            unique++;
+        }
+        remap[i] = table[slot];
+    }
+
+    vertices.resize(unique * stride);
+    for (size_t i = 0; i < indices.size(); i++)
+        indices[i] = remap[indices[i]];
+}
+
+static float forsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+    return score + FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Vertex -> triangle adjacency; each vertex's list shrinks as triangles are emitted
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++)
+        remaining[indices[i]]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> adjacency(indexCount);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+
+    std::vector<unsigned char> emitted(triangleCount, 0);
+
+    std::vector<unsigned int> output(indexCount);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scan = 0;  // Fallback cursor when no cached vertex has triangles left
+    int best = -1;
+    for (size_t out = 0; out < triangleCount; out++)
+    {
+        if (best < 0)
+        {
+            while (emitted[scan])
+                scan++;
+            best = (int)scan;
+        }
+
+        unsigned int t = (unsigned int)best;
+        emitted[t] = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            output[out * 3 + k] = v;
+
+            // Remove t from v's adjacency
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* end = begin + remaining[v];
+            *std::find(begin, end, t) = *(end - 1);
+            remaining[v]--;
+        }
+
+        // New cache: the triangle's vertices on top, then the old contents
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+            nextCache.push_back(indices[t * 3 + k]);
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            unsigned int v = cache[i];
+            if (v != indices[t * 3] && v != indices[t * 3 + 1] && v != indices[t * 3 + 2])
+                nextCache.push_back(v);
+        }
+        for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); i++)
+        {
+            cachePosition[nextCache[i]] = -1;
+            vertexScore[nextCache[i]] = forsythVertexScore(-1, remaining[nextCache[i]]);
+        }
+        if (nextCache.size() > (size_t)FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            cachePosition[cache[i]] = (int)i;
+            vertexScore[cache[i]] = forsythVertexScore((int)i, remaining[cache[i]]);
+        }
+
+        // Rescore the triangles around cached vertices and pick the best
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            unsigned int v = cache[i];
+            for (unsigned int j = 0; j < remaining[v]; j++)
+            {
+                unsigned int neighbour = adjacency[offsets[v] + j];
+                float score = vertexScore[indices[neighbour * 3]] + vertexScore[indices[neighbour * 3 + 1]] + vertexScore[indices[neighbour * 3 + 2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = (int)neighbour;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.data(), indexCount * sizeof(unsigned int));
+}
+
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    VertexCacheStats original = analyzeVertexCache(indices, indexCount, vertexCount);
+
+    // Hard boundaries: triangles whose three vertices all miss the cache
+    std::vector<size_t> clusterStart;
+    std::vector<size_t> enteredAt(vertexCount, 0);
+    std::vector<unsigned char> seen(vertexCount, 0);
+    size_t misses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int triangleMisses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (seen[v] && misses - enteredAt[v] < VERTEX_CACHE_SIZE)
+                continue;
+            seen[v] = 1;
+            enteredAt[v] = misses++;
+            triangleMisses++;
+        }
+        if (t == 0 || triangleMisses == 3)
+            clusterStart.push_back(t);
+    }
+    if (clusterStart.size() < 2)
+        return;
+    clusterStart.push_back(triangleCount);
+
+    // Area-weighted centroid and normal of every cluster and of the whole mesh
+    size_t clusterCount = clusterStart.size() - 1;
+    std::vector<float> centroids(clusterCount * 3, 0.0f), normals(clusterCount * 3, 0.0f);
+    std::vector<float> areas(clusterCount, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+        {
+            const float* a = vertices + indices[t * 3] * stride;
+            const float* b = vertices + indices[t * 3 + 1] * stride;
+            const float* p = vertices + indices[t * 3 + 2] * stride;
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int k = 0; k < 3; k++)
+            {
+                float center = (a[k] + b[k] + p[k]) / 3.0f;
+                centroids[c * 3 + k] += center * area;
+                normals[c * 3 + k] += n[k];
+                meshCentroid[k] += center * area;
+            }
+            areas[c] += area;
+            meshArea += area;
+        }
+    }
+    if (meshArea <= 0.0f)
+        return;
+    for (int k = 0; k < 3; k++)
+        meshCentroid[k] /= meshArea;
+
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float* n = &normals[c * 3];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float inv = length > 0.0f ? 1.0f / length : 0.0f;
+        float invArea = areas[c] > 0.0f ? 1.0f / areas[c] : 0.0f;
+        float dot = 0.0f;
+        for (int k = 0; k < 3; k++)
+            dot += (centroids[c * 3 + k] * invArea - meshCentroid[k]) * n[k] * inv;
+        sortKey[c] = dot;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indexCount);
+    for (size_t i = 0; i < clusterCount; i++)
+    {
+        size_t c = order[i];
+        result.insert(result.end(), indices + clusterStart[c] * 3, indices + clusterStart[c + 1] * 3);
+    }
+
+    VertexCacheStats sorted = analyzeVertexCache(result.data(), indexCount, vertexCount);
+    if (sorted.acmr() <= original.acmr() * threshold)
+        memcpy(indices, result.data(), indexCount * sizeof(unsigned int));
+}
+
+void optimizeVertexFetch(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<float>& scratch)
+{
+    size_t vertexCount = vertices.size() / stride;
+    std::vector<unsigned int> remap(vertexCount, ~0u);
+    std::vector<float>& reordered = scratch;
+    reordered.clear();
+    reordered.reserve(vertices.size());
+
+    unsigned int next = 0;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int v = indices[i];
+        if (remap[v] == ~0u)
+        {
+            remap[v] = next++;
+            reordered.insert(reordered.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+        }
+        indices[i] = remap[v];
+    }
+    vertices.swap(reordered);
+}
+
+MeshOptimizeStats optimizeMesh(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<float>& scratch)
+{
+    MeshOptimizeStats stats;
+    stats.verticesBefore = vertices.size() / stride;
+    stats.before = analyzeVertexCache(indices.data(), indices.size(), stats.verticesBefore);
+
+    weldVertices(vertices, stride, indices);
+    size_t vertexCount = vertices.size() / stride;
+    optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, stride);
+    optimizeVertexFetch(vertices, stride, indices, scratch);
+
+    stats.verticesAfter = vertices.size() / stride;
+    stats.after = analyzeVertexCache(indices.data(), indices.size(), stats.verticesAfter);
+    return stats;
+}
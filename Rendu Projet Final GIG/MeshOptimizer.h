@@ -0,0 +1,61 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+// FIFO post-transform cache size used to measure ACMR/ATVR; a conservative
+// match for current GPUs, which batch vertices rather than keep a true cache
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Accepted ACMR growth of the overdraw pass over the cache-optimized order
+const float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+// Vertex shader invocations of an index buffer under a FIFO cache
+struct VertexCacheStats {
+    size_t triangles = 0;
+    size_t vertices = 0;  // Distinct vertices referenced
+    size_t misses = 0;
+
+    float acmr() const { return triangles ? (float)misses / triangles : 0.0f; }  // Average cache miss ratio, 0.5 - 3
+    float atvr() const { return vertices ? (float)misses / vertices : 0.0f; }    // Average transformed vertex ratio, 1 is ideal
+
+    void add(const VertexCacheStats& other);
+};
+
+struct MeshOptimizeStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    VertexCacheStats before;
+    VertexCacheStats after;
+
+    void add(const MeshOptimizeStats& other);
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Merge bitwise-identical vertices (stride floats each) through a hash table
+// and remap indices; the vertex array shrinks to the unique vertices
+void weldVertices(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices);
+
+// Reorder triangles for the post-transform cache (Forsyth's linear-speed algorithm)
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+// Split the cache-optimized order into clusters at hard cache boundaries and
+// draw the most outward-facing clusters first, so they occlude the rest.
+// Kept only if ACMR grows by less than threshold.
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* vertices, size_t vertexCount, size_t stride,
+    float threshold = OVERDRAW_ACMR_THRESHOLD);
+
+// Renumber vertices in first-use order so fetches walk memory linearly;
+// unreferenced vertices are dropped. The reordered vertices are built in
+// scratch and swapped with vertices, so a caller that keeps both vectors
+// reuses their storage from one mesh to the next.
+void optimizeVertexFetch(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<float>& scratch);
+
+// The whole pipeline: weld, vertex cache, overdraw, vertex fetch
+MeshOptimizeStats optimizeMesh(std::vector<float>& vertices, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<float>& scratch);
+
+#endif
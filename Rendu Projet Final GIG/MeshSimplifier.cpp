@@ -0,0 +1,354 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+// A collapse is rejected if it turns a remaining triangle's normal further
+// than this (cosine), which also catches flipped triangles
+const float SIMPLIFY_MIN_NORMAL_COS = 0.2f;
+
+// Sum of squared distances to a set of planes, weighted by triangle area:
+// error(p) = p^T A p + 2 b.p + c, divided by the total weight w
+struct Quadric {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double w;
+};
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+static void addPlane(Quadric& q, double nx, double ny, double nz, double d, double weight)
+{
+    q.a00 += weight * nx * nx; q.a01 += weight * nx * ny; q.a02 += weight * nx * nz;
+    q.a11 += weight * ny * ny; q.a12 += weight * ny * nz; q.a22 += weight * nz * nz;
+    q.b0 += weight * nx * d; q.b1 += weight * ny * d; q.b2 += weight * nz * d;
+    q.c += weight * d * d;
+    q.w += weight;
+}
+
+static void addQuadric(Quadric& q, const Quadric& other)
+{
+    q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02;
+    q.a11 += other.a11; q.a12 += other.a12; q.a22 += other.a22;
+    q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+    q.c += other.c;
+    q.w += other.w;
+}
+
+// Mean squared distance of p to the quadric's planes
+static double evaluate(const Quadric& q, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double error = x * (q.a00 * x + q.a01 * y + q.a02 * z)
+        + y * (q.a01 * x + q.a11 * y + q.a12 * z)
+        + z * (q.a02 * x + q.a12 * y + q.a22 * z)
+        + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return (q.w > 0.0) ? fmax(error, 0.0) / q.w : 0.0;
+}
+
+static void triangleNormal(const float* a, const float* b, const float* c, float* normal)
+{
+    float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static unsigned int findGroup(const std::vector<unsigned int>& remap, unsigned int group)
+{
+    while (remap[group] != group)
+        group = remap[group];
+    return group;
+}
+
+std::vector<unsigned int> simplifyMesh(const float* vertices, size_t vertexCount, size_t stride,
+    const unsigned int* indices, size_t indexCount, size_t targetIndexCount, float maxError, float& error)
+{
+    error = 0.0f;
+
+    // Vertices with the same position form one group; groups are what collapses
+    std::vector<unsigned int> order(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+        order[i] = (unsigned int)i;
+    std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        const float* pa = vertices + a * stride;
+        const float* pb = vertices + b * stride;
+        if (pa[0] != pb[0]) return pa[0] < pb[0];
+        if (pa[1] != pb[1]) return pa[1] < pb[1];
+        return pa[2] < pb[2];
+    });
+
+    std::vector<unsigned int> groupOf(vertexCount);
+    std::vector<unsigned int> groupStart;  // Members of group g: order[groupStart[g], groupStart[g + 1])
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* p = vertices + order[i] * stride;
+        const float* previous = (i > 0) ? vertices + order[i - 1] * stride : NULL;
+        if (!previous || p[0] != previous[0] || p[1] != previous[1] || p[2] != previous[2])
+            groupStart.push_back((unsigned int)i);
+        groupOf[order[i]] = (unsigned int)groupStart.size() - 1;
+    }
+    size_t groupCount = groupStart.size();
+    groupStart.push_back((unsigned int)vertexCount);
+
+    // Triangles as groups; input triangles that are already degenerate are dropped
+    std::vector<unsigned int> triangles;    // Vertex indices
+    std::vector<unsigned int> triGroups;    // Current group of each corner
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned int g0 = groupOf[indices[i]], g1 = groupOf[indices[i + 1]], g2 = groupOf[indices[i + 2]];
+        if (g0 == g1 || g1 == g2 || g0 == g2)
+            continue;
+        triangles.insert(triangles.end(), indices + i, indices + i + 3);
+        triGroups.push_back(g0);
+        triGroups.push_back(g1);
+        triGroups.push_back(g2);
+    }
+
+    // Open and non-manifold edges lock their ends
+    std::vector<unsigned char> locked(groupCount, 0);
+    std::unordered_map<uint64_t, unsigned int> edgeUses;
+    for (size_t i = 0; i < triGroups.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+            edgeUses[((uint64_t)triGroups[i + k] << 32) | triGroups[i + (k + 1) % 3]]++;
+    }
+    for (std::unordered_map<uint64_t, unsigned int>::const_iterator it = edgeUses.begin(); it != edgeUses.end(); ++it)
+    {
+        unsigned int a = (unsigned int)(it->first >> 32), b = (unsigned int)it->first;
+        std::unordered_map<uint64_t, unsigned int>::const_iterator reverse = edgeUses.find(((uint64_t)b << 32) | a);
+        if (it->second > 1 || reverse == edgeUses.end() || reverse->second > 1)
+            locked[a] = locked[b] = 1;
+    }
+
+    std::vector<Quadric> quadrics(groupCount, Quadric());
+    for (size_t i = 0; i < triGroups.size(); i += 3)
+    {
+        const float* p0 = vertices + order[groupStart[triGroups[i]]] * stride;
+        const float* p1 = vertices + order[groupStart[triGroups[i + 1]]] * stride;
+        const float* p2 = vertices + order[groupStart[triGroups[i + 2]]] * stride;
+        float n[3];
+        triangleNormal(p0, p1, p2, n);
+        double length = sqrt((double)n[0] * n[0] + (double)n[1] * n[1] + (double)n[2] * n[2]);
+        if (length <= 0.0)
+            continue;
+
+        double nx = n[0] / length, ny = n[1] / length, nz = n[2] / length;
+        double d = -(nx * p0[0] + ny * p0[1] + nz * p0[2]);
+        for (int k = 0; k < 3; k++)
+            addPlane(quadrics[triGroups[i + k]], nx, ny, nz, d, length * 0.5);
+    }
+
+    std::vector<unsigned int> remap(groupCount);
+    for (size_t g = 0; g < groupCount; g++)
+        remap[g] = (unsigned int)g;
+
+    double maxCost = (maxError < FLT_MAX) ? (double)maxError * maxError : DBL_MAX;
+    double worst = 0.0;
+    size_t triangleCount = triGroups.size() / 3;
+    size_t targetTriangles = targetIndexCount / 3;
+
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> adjacencyStart, adjacency;
+    std::vector<unsigned char> touched;
+
+    // Each pass collapses the cheapest edges whose ends no other collapse of
+    // the pass has moved, then rebuilds the triangle list
+    while (triangleCount > targetTriangles)
+    {
+        edges.clear();
+        for (size_t i = 0; i < triGroups.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = triGroups[i + k], b = triGroups[i + (k + 1) % 3];
+                edges.push_back(((uint64_t)std::min(a, b) << 32) | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            unsigned int a = (unsigned int)(edges[i] >> 32), b = (unsigned int)edges[i];
+            Quadric q = quadrics[a];
+            addQuadric(q, quadrics[b]);
+
+            Collapse collapse;
+            collapse.cost = DBL_MAX;
+            if (!locked[a])
+            {
+                collapse.from = a;
+                collapse.to = b;
+                collapse.cost = evaluate(q, vertices + order[groupStart[b]] * stride);
+            }
+            double reverseCost = locked[b] ? DBL_MAX : evaluate(q, vertices + order[groupStart[a]] * stride);
+            if (reverseCost < collapse.cost)
+            {
+                collapse.from = b;
+                collapse.to = a;
+                collapse.cost = reverseCost;
+            }
+            if (collapse.cost < DBL_MAX)
+                collapses.push_back(collapse);
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Triangles around each group
+        adjacencyStart.assign(groupCount + 1, 0);
+        for (size_t i = 0; i < triGroups.size(); i++)
+            adjacencyStart[triGroups[i] + 1]++;
+        for (size_t g = 0; g < groupCount; g++)
+            adjacencyStart[g + 1] += adjacencyStart[g];
+        adjacency.resize(triGroups.size());
+        std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t i = 0; i < triGroups.size(); i++)
+            adjacency[fill[triGroups[i]]++] = (unsigned int)(i / 3);
+
+        touched.assign(groupCount, 0);
+        size_t collapsed = 0;
+        for (size_t i = 0; i < collapses.size() && triangleCount > targetTriangles; i++)
+        {
+            const Collapse& collapse = collapses[i];
+            if (collapse.cost > maxCost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            const float* target = vertices + order[groupStart[collapse.to]] * stride;
+            size_t removed = 0;
+            bool accepted = true;
+            for (unsigned int j = adjacencyStart[collapse.from]; j < adjacencyStart[collapse.from + 1] && accepted; j++)
+            {
+                unsigned int t = adjacency[j];
+                unsigned int g[3];
+                for (int k = 0; k < 3; k++)
+                    g[k] = findGroup(remap, triGroups[t * 3 + k]);
+                if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2])
+                    continue;  // Already removed by an earlier collapse of this pass
+                if (g[0] == collapse.to || g[1] == collapse.to || g[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                const float* before[3];
+                const float* after[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = vertices + order[groupStart[g[k]]] * stride;
+                    after[k] = (g[k] == collapse.from) ? target : before[k];
+                }
+                float n0[3], n1[3];
+                triangleNormal(before[0], before[1], before[2], n0);
+                triangleNormal(after[0], after[1], after[2], n1);
+                float dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                float lengths = sqrtf((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+                if (dot < SIMPLIFY_MIN_NORMAL_COS * lengths)
+                    accepted = false;
+            }
+            if (!accepted)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            touched[collapse.from] = touched[collapse.to] = 1;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            triangleCount -= removed;
+            worst = std::max(worst, collapse.cost);
+            collapsed++;
+        }
+
+        if (collapsed == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < triGroups.size(); i += 3)
+        {
+            unsigned int g0 = findGroup(remap, triGroups[i]);
+            unsigned int g1 = findGroup(remap, triGroups[i + 1]);
+            unsigned int g2 = findGroup(remap, triGroups[i + 2]);
+            if (g0 == g1 || g1 == g2 || g0 == g2)
+                continue;
+            for (int k = 0; k < 3; k++)
+                triangles[kept + k] = triangles[i + k];
+            triGroups[kept] = g0;
+            triGroups[kept + 1] = g1;
+            triGroups[kept + 2] = g2;
+            kept += 3;
+        }
+        triangles.resize(kept);
+        triGroups.resize(kept);
+        triangleCount = kept / 3;
+    }
+
+    // A corner whose group moved takes the vertex of its new group whose
+    // normal and UVs are closest to the original, so seams survive
+    std::vector<unsigned int> result(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned int vertex = triangles[i];
+        unsigned int group = triGroups[i];
+        if (group == groupOf[vertex])
+        {
+            result[i] = vertex;
+            continue;
+        }
+
+        const float* source = vertices + vertex * stride;
+        float bestDistance = FLT_MAX;
+        for (unsigned int j = groupStart[group]; j < groupStart[group + 1]; j++)
+        {
+            const float* candidate = vertices + order[j] * stride;
+            float distance = 0.0f;
+            if (stride >= 6)
+                distance += 1.0f - (source[3] * candidate[3] + source[4] * candidate[4] + source[5] * candidate[5]);
+            if (stride >= 8)
+                distance += (source[6] - candidate[6]) * (source[6] - candidate[6]) + (source[7] - candidate[7]) * (source[7] - candidate[7]);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                result[i] = order[j];
+            }
+        }
+    }
+
+    error = (float)sqrt(worst);
+    return result;
+}
+
+void generateLods(const float* vertices, size_t vertexCount, size_t stride, const std::vector<unsigned int>& indices,
+    std::vector<std::vector<unsigned int> >& lodIndices, std::vector<float>& lodErrors)
+{
+    lodIndices.clear();
+    lodErrors.clear();
+
+    // Every level starts from the full mesh so its error is absolute
+    size_t previous = indices.size();
+    while (lodIndices.size() + 1 < MAX_LODS)
+    {
+        size_t target = (size_t)(previous / 3 * LOD_TRIANGLE_RATIO) * 3;
+        if (target / 3 < LOD_MIN_TRIANGLES)
+            break;
+
+        float error;
+        std::vector<unsigned int> lod = simplifyMesh(vertices, vertexCount, stride, indices.data(), indices.size(), target, FLT_MAX, error);
+        if (lod.size() > previous * LOD_MIN_REDUCTION)
+            break;
+
+        optimizeVertexCache(lod.data(), lod.size(), vertexCount);
+        lodErrors.push_back(lodErrors.empty() ? error : std::max(error, lodErrors.back()));
+        lodIndices.push_back(lod);
+        previous = lod.size();
+    }
+}
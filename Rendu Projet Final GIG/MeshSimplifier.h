@@ -0,0 +1,32 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+// LOD chain generation: every level aims for LOD_TRIANGLE_RATIO of the
+// previous one and is dropped if it keeps more than LOD_MIN_REDUCTION of them
+const unsigned int MAX_LODS = 5;  // Including the full mesh
+const float LOD_TRIANGLE_RATIO = 0.5f;
+const float LOD_MIN_REDUCTION = 0.85f;
+const size_t LOD_MIN_TRIANGLES = 16;
+
+// Quadric error edge collapse (Garland-Heckbert) on an indexed triangle list.
+// Only the index buffer changes: each collapse moves one vertex onto the
+// other end of the edge, so the result indexes the same vertices. Vertices
+// sharing a position (normal or UV seams) collapse together, and open borders
+// are locked so the silhouette keeps no holes.
+//
+// Stops at targetIndexCount or when the next collapse would exceed maxError,
+// whichever comes first. error receives the largest collapse error, as a
+// distance in the units of the positions (the first three of stride floats;
+// floats 3-5 are a normal and 6-7 texture coordinates when stride allows).
+std::vector<unsigned int> simplifyMesh(const float* vertices, size_t vertexCount, size_t stride,
+    const unsigned int* indices, size_t indexCount, size_t targetIndexCount, float maxError, float& error);
+
+// Index buffers of up to MAX_LODS - 1 coarser levels of a mesh (cache
+// optimized), coarsest last, and their errors
+void generateLods(const float* vertices, size_t vertexCount, size_t stride, const std::vector<unsigned int>& indices,
+    std::vector<std::vector<unsigned int> >& lodIndices, std::vector<float>& lodErrors);
+
+#endif
@@ -0,0 +1,155 @@
+#include "Meshlet.h"
+#include <cfloat>
+
+// Weight of the normal deviation against one extra vertex when growing a meshlet
+const float MESHLET_CONE_WEIGHT = 0.5f;
+
+static Vector3 faceNormal(const float* vertices, size_t stride, const unsigned int* triangle)
+{
+    const float* a = vertices + triangle[0] * stride;
+    const float* b = vertices + triangle[1] * stride;
+    const float* c = vertices + triangle[2] * stride;
+    Vector3 e1(b[0] - a[0], b[1] - a[1], b[2] - a[2]);
+    Vector3 e2(c[0] - a[0], c[1] - a[1], c[2] - a[2]);
+    Vector3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+    float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    return (length > 0.0f) ? n * (1.0f / length) : Vector3();
+}
+
+// Sphere and normal cone of the triangles of one meshlet
+static void computeMeshletBounds(const float* vertices, size_t stride, const unsigned int* indices, Meshlet& meshlet,
+    std::vector<float>& positions)
+{
+    positions.clear();
+    Vector3 axis;
+    for (GLsizei i = 0; i < meshlet.indexCount; i += 3)
+    {
+        const unsigned int* triangle = indices + meshlet.firstIndex + i;
+        for (int k = 0; k < 3; k++)
+            positions.insert(positions.end(), vertices + triangle[k] * stride, vertices + triangle[k] * stride + 3);
+        axis = axis + faceNormal(vertices, stride, triangle);
+    }
+    meshlet.sphere = computeBounds(positions.data(), positions.size() / 3, 3).sphere;
+
+    float length = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+    meshlet.coneAxis = (length > 0.0f) ? axis * (1.0f / length) : Vector3();
+    meshlet.coneCutoff = 1.0f;
+    if (length <= 0.0f)
+        return;
+
+    float minDot = 1.0f;
+    for (GLsizei i = 0; i < meshlet.indexCount; i += 3)
+    {
+        Vector3 n = faceNormal(vertices, stride, indices + meshlet.firstIndex + i);
+        if (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f)
+            continue;
+        minDot = fminf(minDot, n.x * meshlet.coneAxis.x + n.y * meshlet.coneAxis.y + n.z * meshlet.coneAxis.z);
+    }
+    if (minDot > 0.0f)
+        meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void buildMeshlets(const float* vertices, size_t vertexCount, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<Meshlet>& meshlets)
+{
+    meshlets.clear();
+    size_t triangleCount = indices.size() / 3;
+
+    // Triangles around each vertex
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacencyStart[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<Vector3> normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        normals[t] = faceNormal(vertices, stride, &indices[t * 3]);
+
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<unsigned int> vertexMeshlet(vertexCount, ~0u);  // Meshlet that last took the vertex
+    std::vector<unsigned int> meshletVertices;
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    size_t seed = 0;
+    while (true)
+    {
+        while (seed < triangleCount && emitted[seed])
+            seed++;
+        if (seed == triangleCount)
+            break;
+
+        unsigned int id = (unsigned int)meshlets.size();
+        Meshlet meshlet = {};
+        meshlet.firstIndex = (GLuint)result.size();
+        meshletVertices.clear();
+        Vector3 axis;
+
+        size_t next = seed;
+        while (true)
+        {
+            emitted[next] = 1;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[next * 3 + k];
+                if (vertexMeshlet[v] != id)
+                {
+                    vertexMeshlet[v] = id;
+                    meshletVertices.push_back(v);
+                }
+                result.push_back(v);
+            }
+            meshlet.indexCount += 3;
+            axis = axis + normals[next];
+            if ((size_t)meshlet.indexCount / 3 == MESHLET_MAX_TRIANGLES)
+                break;
+
+            // Best remaining triangle around the meshlet's vertices
+            float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+            Vector3 direction = (axisLength > 0.0f) ? axis * (1.0f / axisLength) : Vector3();
+            float bestScore = FLT_MAX;
+            size_t best = triangleCount;
+            for (size_t i = 0; i < meshletVertices.size(); i++)
+            {
+                unsigned int v = meshletVertices[i];
+                for (unsigned int j = adjacencyStart[v]; j < adjacencyStart[v + 1]; j++)
+                {
+                    unsigned int t = adjacency[j];
+                    if (emitted[t])
+                        continue;
+
+                    int newVertices = 0;
+                    for (int k = 0; k < 3; k++)
+                        newVertices += (vertexMeshlet[indices[t * 3 + k]] != id) ? 1 : 0;
+                    if (meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES)
+                        continue;
+
+                    const Vector3& n = normals[t];
+                    float bend = 1.0f - (n.x * direction.x + n.y * direction.y + n.z * direction.z);
+                    float score = newVertices + MESHLET_CONE_WEIGHT * bend;
+                    if (score < bestScore)
+                    {
+                        bestScore = score;
+                        best = t;
+                    }
+                }
+            }
+            if (best == triangleCount)
+                break;
+            next = best;
+        }
+
+        meshlets.push_back(meshlet);
+    }
+
+    indices.swap(result);
+
+    std::vector<float> positions;
+    for (size_t i = 0; i < meshlets.size(); i++)
+        computeMeshletBounds(vertices, stride, indices.data(), meshlets[i], positions);
+}
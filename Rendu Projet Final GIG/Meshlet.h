@@ -0,0 +1,45 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <glad/glad.h>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "Bounds.h"
+
+// Cluster limits, the usual mesh shader sizes (the triangle count is kept a
+// multiple of four so packed 8-bit triangle lists stay aligned)
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+// A contiguous run of indices whose triangles touch at most
+// MESHLET_MAX_VERTICES vertices. Every triangle normal lies within the cone
+// around coneAxis whose half angle has coneCutoff as its sine; coneCutoff is 1
+// when the normals span a half space or more, which disables cone culling.
+struct Meshlet {
+    GLuint firstIndex;      // Relative to the indices given to buildMeshlets
+    GLsizei indexCount;
+    BoundingSphere sphere;  // Same space as the vertices
+    Vector3 coneAxis;
+    float coneCutoff;
+};
+
+// Reorder the triangles of indices into meshlets, grown greedily from a seed
+// triangle through the triangles that add the fewest new vertices and bend
+// the cluster's normal the least. Positions are the first three of stride
+// floats; the vertices themselves are not modified.
+void buildMeshlets(const float* vertices, size_t vertexCount, size_t stride, std::vector<unsigned int>& indices,
+    std::vector<Meshlet>& meshlets);
+
+// True when every triangle of the meshlet faces away from eye (given in the
+// meshlet's space), assuming counter-clockwise front faces. Conservative: the
+// whole bounding sphere must lie inside the back-facing cone.
+inline bool meshletBackfacing(const Meshlet& meshlet, const Vector3& eye)
+{
+    Vector3 toCenter = meshlet.sphere.center - eye;
+    float distance = sqrtf(toCenter.x * toCenter.x + toCenter.y * toCenter.y + toCenter.z * toCenter.z);
+    float along = toCenter.x * meshlet.coneAxis.x + toCenter.y * meshlet.coneAxis.y + toCenter.z * meshlet.coneAxis.z;
+    return along - meshlet.sphere.radius > meshlet.coneCutoff * (distance + meshlet.sphere.radius);
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "ModelBatch.h"
+#include "GLStateCache.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+
+static double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Append model's vertices and indices to geometry and shift its ranges to
+// match. Indices stay relative to baseVertex, so only the ranges move.
+static void mergeModel(Mesh& geometry, Mesh& model)
+{
+    GLint vertexOffset = (GLint)(geometry.vertices.size() / MODEL_VERTEX_FLOATS);
+    GLuint indexOffset = (GLuint)geometry.indices.size();
+
+    for (size_t i = 0; i < model.submeshes.size(); i++)
+    {
+        Submesh& submesh = model.submeshes[i];
+        submesh.baseVertex += vertexOffset;
+        submesh.firstIndex += indexOffset;
+        for (unsigned int level = 0; level < submesh.lodCount; level++)
+        {
+            submesh.lods[level].baseVertex += vertexOffset;
+            submesh.lods[level].firstIndex += indexOffset;
+        }
+    }
+    for (size_t i = 0; i < model.meshlets.size(); i++)
+        model.meshlets[i].firstIndex += indexOffset;
+
+    geometry.vertices.insert(geometry.vertices.end(), model.vertices.begin(), model.vertices.end());
+    geometry.indices.insert(geometry.indices.end(), model.indices.begin(), model.indices.end());
+    std::vector<float>().swap(model.vertices);
+    std::vector<unsigned int>().swap(model.indices);
+}
+
+bool ModelBatchLoader::load(const std::vector<ModelRequest>& requests, ModelBatch& batch)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    batch = ModelBatch();
+    batch.models.resize(requests.size());
+
+    // Each distinct path is read once
+    std::map<std::string, size_t> modelSlots;
+    std::map<std::string, size_t> textureSlots;
+    std::vector<size_t> firstUse;  // Request that reads each model slot
+    std::vector<size_t> modelSlot(requests.size());
+    std::vector<int> textureSlot(requests.size(), -1);
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        batch.models[i].path = requests[i].modelPath;
+        std::map<std::string, size_t>::iterator model = modelSlots.find(requests[i].modelPath);
+        if (model == modelSlots.end())
+        {
+            model = modelSlots.insert(std::make_pair(requests[i].modelPath, firstUse.size())).first;
+            firstUse.push_back(i);
+        }
+        modelSlot[i] = model->second;
+
+        if (requests[i].texturePath.empty())
+            continue;
+        std::map<std::string, size_t>::iterator texture = textureSlots.find(requests[i].texturePath);
+        if (texture == textureSlots.end())
+        {
+            texture = textureSlots.insert(std::make_pair(requests[i].texturePath, batch.textures.size())).first;
+            batch.textures.push_back(BatchTexture());
+            batch.textures.back().path = requests[i].texturePath;
+        }
+        textureSlot[i] = (int)texture->second;
+    }
+
+    size_t taskCount = firstUse.size() + batch.textures.size();
+    unsigned int workers = (workerCount > 0) ? workerCount : ThreadPool::defaultWorkerCount();
+    workers = (unsigned int)std::max<size_t>(std::min<size_t>(workers, taskCount), 1);
+    batch.workerCount = workers;
+
+    std::vector<std::unique_ptr<Assimp::Importer> > importers;
+    for (unsigned int i = 0; i < workers; i++)
+        importers.push_back(std::unique_ptr<Assimp::Importer>(new Assimp::Importer()));
+
+    // Models first: they are the long tasks, textures fill in behind them
+    unsigned int options = buildMeshlets ? MODEL_OPTION_MESHLETS : 0;
+    std::vector<TextureImage> images(batch.textures.size(), TextureImage());
+    ThreadPool pool;
+    pool.start(workers);
+    for (size_t slot = 0; slot < firstUse.size(); slot++)
+    {
+        BatchModel& model = batch.models[firstUse[slot]];
+        model.mesh.format = vertexFormat;
+        pool.submit([&model, &importers, options](unsigned int worker) {
+            std::chrono::steady_clock::time_point taskStart = std::chrono::steady_clock::now();
+            model.loaded = readModel(model.path, options, model.mesh, importers[worker].get(), &model.importReport);
+            model.loadMs = msSince(taskStart);
+        });
+    }
+    for (size_t slot = 0; slot < batch.textures.size(); slot++)
+    {
+        BatchTexture& texture = batch.textures[slot];
+        TextureImage& image = images[slot];
+        pool.submit([&texture, &image](unsigned int) {
+            std::chrono::steady_clock::time_point taskStart = std::chrono::steady_clock::now();
+            decodeTexture(texture.path, image);
+            texture.decodeMs = msSince(taskStart);
+        });
+    }
+    pool.wait();
+    pool.stop();
+
+    // Merge in request order, then upload everything once
+    Mesh& geometry = batch.geometry;
+    geometry.format = vertexFormat;
+    size_t vertexFloats = 0;
+    size_t indexCount = 0;
+    for (size_t slot = 0; slot < firstUse.size(); slot++)
+    {
+        vertexFloats += batch.models[firstUse[slot]].mesh.vertices.size();
+        indexCount += batch.models[firstUse[slot]].mesh.indices.size();
+    }
+    geometry.vertices.reserve(vertexFloats);
+    geometry.indices.reserve(indexCount);
+    for (size_t slot = 0; slot < firstUse.size(); slot++)
+    {
+        BatchModel& model = batch.models[firstUse[slot]];
+        if (model.loaded)
+            mergeModel(geometry, model.mesh);
+    }
+    if (!geometry.indices.empty())
+        uploadMesh(geometry, geometry.vertices.data(), geometry.vertices.size() / MODEL_VERTEX_FLOATS,
+            geometry.indices.data(), geometry.indices.size());
+    if (!keepCpuData)
+        releaseCpuData(geometry);
+
+    for (size_t slot = 0; slot < batch.textures.size(); slot++)
+    {
+        if (images[slot].pixels)
+            batch.textures[slot].textureID = createTexture(images[slot]);
+        freeTexture(images[slot]);
+    }
+
+    bool allLoaded = true;
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        BatchModel& model = batch.models[i];
+        if (i != firstUse[modelSlot[i]])
+        {
+            const BatchModel& source = batch.models[firstUse[modelSlot[i]]];
+            model.loaded = source.loaded;
+            model.mesh = source.mesh;
+        }
+        allLoaded = allLoaded && model.loaded;
+        if (!model.loaded)
+            continue;
+
+        Mesh& mesh = model.mesh;
+        mesh.VAO = geometry.VAO;
+        mesh.VBO = geometry.VBO;
+        mesh.EBO = geometry.EBO;
+        mesh.indexType = geometry.indexType;
+        for (int c = 0; c < 3; c++)
+        {
+            mesh.positionOffset[c] = geometry.positionOffset[c];
+            mesh.positionScale[c] = geometry.positionScale[c];
+        }
+        for (int c = 0; c < 4; c++)
+            mesh.texCoordTransform[c] = geometry.texCoordTransform[c];
+        mesh.textureID = (textureSlot[i] >= 0) ? batch.textures[textureSlot[i]].textureID : 0;
+    }
+
+    batch.wallMs = msSince(start);
+    return allLoaded;
+}
+
+void ModelBatch::destroy()
+{
+    if (geometry.VAO)
+        destroyMeshBuffers(geometry);
+    for (size_t i = 0; i < textures.size(); i++)
+        glDeleteTextures(1, &textures[i].textureID);
+    glState.invalidate();
+    models.clear();
+    textures.clear();
+}
+
+void ModelBatch::report(std::ostream& out) const
+{
+    double serialMs = 0.0;
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        const BatchModel& model = models[i];
+        serialMs += model.loadMs;
+        model.importReport.print(out, model.path);
+        out << "  " << model.path << ": " << (model.loaded ? "" : "FAILED, ") << model.loadMs << " ms" << std::endl;
+    }
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        serialMs += textures[i].decodeMs;
+        out << "  " << textures[i].path << ": " << textures[i].decodeMs << " ms" << std::endl;
+    }
+    out << "Batch import: " << models.size() << " models, " << textures.size() << " textures in " << wallMs
+        << " ms on " << workerCount << " threads (" << serialMs << " ms of work)" << std::endl;
+}
@@ -0,0 +1,56 @@
+#ifndef MODELBATCH_H
+#define MODELBATCH_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+struct ModelRequest {
+    std::string modelPath;
+    std::string texturePath;  // May be empty
+};
+
+struct BatchModel {
+    std::string path;
+    bool loaded = false;
+    double loadMs = 0.0;  // Worker time of the read or import; 0 for a repeated path
+    ModelImportReport importReport;  // Printed by ModelBatch::report
+    Mesh mesh;            // Ranges point into ModelBatch::geometry, whose GL objects it shares
+};
+
+struct BatchTexture {
+    std::string path;
+    GLuint textureID = 0;
+    double decodeMs = 0.0;
+};
+
+// Every model of a batch packed into one VAO/VBO/EBO, so all of them can be
+// drawn by one multi-draw. geometry holds the vertices and indices; each
+// model's Mesh keeps its own tables with the ranges rebased.
+struct ModelBatch {
+    Mesh geometry = Mesh();
+    std::vector<BatchModel> models;      // Same order as the requests
+    std::vector<BatchTexture> textures;  // One per distinct texture path
+    unsigned int workerCount = 0;
+    double wallMs = 0.0;                 // Whole load, GL upload included
+
+    void report(std::ostream& out) const;
+    void destroy();  // Delete the shared buffers and the textures; needs the GL context
+};
+
+// Loads many models at once: every distinct model and texture is read on a
+// ThreadPool, each worker with its own Assimp importer, and the results are
+// merged and uploaded on the calling thread, which must own the GL context.
+class ModelBatchLoader {
+public:
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    bool buildMeshlets = false;  // MODEL_OPTION_MESHLETS
+    bool keepCpuData = false;    // Kept in ModelBatch::geometry, not in the models
+    unsigned int workerCount = 0;  // 0 uses every hardware thread
+
+    // False if any model failed; the others are still usable
+    bool load(const std::vector<ModelRequest>& requests, ModelBatch& batch);
+};
+
+#endif
@@ -1,99 +1,657 @@
 #include "ModelLoader.h"
+#include "GLStateCache.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-GLuint loadTexture(const std::string& path)
+bool decodeTexture(const std::string& path, TextureImage& image)
+{
+    image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+    if (!image.pixels)
+    {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void freeTexture(TextureImage& image)
+{
+    stbi_image_free(image.pixels);
+    image.pixels = NULL;
+}
+
+GLuint createTexture(const TextureImage& image)
 {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data)
+    if (image.pixels)
     {
-        GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        GLenum format = (image.channels == 3) ? GL_RGB : GL_RGBA;
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
         glGenerateMipmap(GL_TEXTURE_2D);
     }
-    else
+    return textureID;
+}
+
+GLuint loadTexture(const std::string& path)
+{
+    TextureImage image = {};
+    decodeTexture(path, image);
+    GLuint textureID = createTexture(image);
+    freeTexture(image);
+    return textureID;
+}
+
+// Assimp matrices are row-major, Mat4 is column-major
+static Mat4 toMat4(const aiMatrix4x4& matrix)
+{
+    Mat4 result;
+    for (int row = 0; row < 4; row++)
     {
-        std::cerr << "Failed to load texture: " << path << std::endl;
+        for (int col = 0; col < 4; col++)
+            result.m[col * 4 + row] = matrix[row][col];
     }
-    stbi_image_free(data);
-    return textureID;
+    return result;
 }
 
-Mesh ModelLoader::loadModel(const std::string& path, const std::string& texturePath)
+// Box of bounds after transform, grown to the eight transformed corners
+static AABB transformBox(const AABB& box, const Mat4& transform)
+{
+    AABB result = {};
+    for (int corner = 0; corner < 8; corner++)
+    {
+        Vector4 p = transform * Vector4((corner & 1) ? box.max.x : box.min.x,
+            (corner & 2) ? box.max.y : box.min.y,
+            (corner & 4) ? box.max.z : box.min.z, 1.0f);
+        if (corner == 0)
+        {
+            result.min = result.max = Vector3(p.x, p.y, p.z);
+            continue;
+        }
+        result.min = Vector3(fminf(result.min.x, p.x), fminf(result.min.y, p.y), fminf(result.min.z, p.z));
+        result.max = Vector3(fmaxf(result.max.x, p.x), fmaxf(result.max.y, p.y), fmaxf(result.max.z, p.z));
+    }
+    return result;
+}
+
+// Per-import buffers reused by every aiMesh, so packing a model does not
+// allocate and grow fresh vectors for each of its meshes. The vertex fetch
+// pass reorders into reordered and swaps it with vertices, so the two
+// trade storage instead of reallocating.
+struct PackScratch {
+    std::vector<float> vertices;
+    std::vector<float> reordered;
+    std::vector<unsigned int> indices;
+};
+
+// Optimize the vertices and indices of one aiMesh, build its LOD chain and
+// append them; returns its range
+static Submesh packMesh(const aiMesh* source, Mesh& mesh, unsigned int options, PackScratch& scratch, MeshOptimizeStats& stats)
+{
+    std::vector<float>& vertices = scratch.vertices;
+    std::vector<unsigned int>& indices = scratch.indices;
+
+    // Written in place rather than pushed one float at a time
+    vertices.resize((size_t)source->mNumVertices * MODEL_VERTEX_FLOATS);
+    const aiVector3D* texCoords = source->mTextureCoords[0];
+    for (unsigned int i = 0; i < source->mNumVertices; i++)
+    {
+        float* v = &vertices[(size_t)i * MODEL_VERTEX_FLOATS];
+        v[0] = source->mVertices[i].x;
+        v[1] = source->mVertices[i].y;
+        v[2] = source->mVertices[i].z;
+        v[3] = source->mNormals[i].x;
+        v[4] = source->mNormals[i].y;
+        v[5] = source->mNormals[i].z;
+        v[6] = texCoords ? texCoords[i].x : 0.0f;
+        v[7] = texCoords ? texCoords[i].y : 0.0f;
+    }
+
+    // Indices stay relative to the mesh; baseVertex offsets them at draw time
+    indices.clear();
+    for (unsigned int i = 0; i < source->mNumFaces; i++)
+    {
+        const aiFace& face = source->mFaces[i];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+
+    stats.add(optimizeMesh(vertices, MODEL_VERTEX_FLOATS, indices, scratch.reordered));
+
+    Submesh range = {};
+    range.baseVertex = (GLint)(mesh.vertices.size() / MODEL_VERTEX_FLOATS);
+    range.firstIndex = (GLuint)mesh.indices.size();
+    range.indexCount = (GLsizei)indices.size();
+    range.materialId = source->mMaterialIndex;
+    range.bounds = computeBounds(vertices.data(), vertices.size() / MODEL_VERTEX_FLOATS, MODEL_VERTEX_FLOATS);
+
+    std::vector<std::vector<unsigned int> > lodIndices;
+    std::vector<float> lodErrors;
+    generateLods(vertices.data(), vertices.size() / MODEL_VERTEX_FLOATS, MODEL_VERTEX_FLOATS, indices, lodIndices, lodErrors);
+
+    // Meshlets reorder the full level only; their index ranges tile it
+    if (options & MODEL_OPTION_MESHLETS)
+    {
+        std::vector<Meshlet> meshlets;
+        buildMeshlets(vertices.data(), vertices.size() / MODEL_VERTEX_FLOATS, MODEL_VERTEX_FLOATS, indices, meshlets);
+        range.firstMeshlet = (GLuint)mesh.meshlets.size();
+        range.meshletCount = (GLuint)meshlets.size();
+        for (size_t i = 0; i < meshlets.size(); i++)
+        {
+            meshlets[i].firstIndex += range.firstIndex;
+            mesh.meshlets.push_back(meshlets[i]);
+        }
+    }
+
+    mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+    mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+
+    // The simplified levels go right after the full index range
+    range.lodCount = 1 + (unsigned int)lodIndices.size();
+    range.lods[0].firstIndex = range.firstIndex;
+    range.lods[0].baseVertex = range.baseVertex;
+    range.lods[0].indexCount = range.indexCount;
+    range.lods[0].error = 0.0f;
+    for (size_t i = 0; i < lodIndices.size(); i++)
+    {
+        LodLevel& level = range.lods[i + 1];
+        level.firstIndex = (GLuint)mesh.indices.size();
+        level.baseVertex = range.baseVertex;
+        level.indexCount = (GLsizei)lodIndices[i].size();
+        level.error = lodErrors[i];
+        mesh.indices.insert(mesh.indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+    }
+    return range;
+}
+
+static void readMaterials(const aiScene* scene, Mesh& mesh)
 {
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+    for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+    {
+        const aiMaterial* source = scene->mMaterials[i];
+        ModelMaterial material;
+        material.name = source->GetName().C_Str();
+
+        aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
+        aiGetMaterialColor(source, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+        material.diffuse[0] = diffuse.r;
+        material.diffuse[1] = diffuse.g;
+        material.diffuse[2] = diffuse.b;
+        material.diffuse[3] = diffuse.a;
+
+        aiString texture;
+        if (source->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == AI_SUCCESS)
+            material.diffuseTexture = texture.C_Str();
+
+        mesh.materials.push_back(material);
+    }
+}
+
+// Import with Assimp into the CPU side of mesh. The scene is freed on
+// return so a reused importer does not hold on to it.
+static bool importModel(const std::string& path, unsigned int options, Mesh& mesh, Assimp::Importer& importer,
+    ModelImportReport& report)
+{
+    const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         std::cerr << "Assimp Error: " << importer.GetErrorString() << std::endl;
-        return {};
+        importer.FreeScene();
+        return false;
     }
 
-    Mesh mesh;
-    aiMesh* aiMesh = scene->mMeshes[0];
+    readMaterials(scene, mesh);
+
+    // Each aiMesh is packed once, the first time a node references it
+    std::vector<int> packed(scene->mNumMeshes, -1);
+    std::vector<Submesh> meshRanges;
+    MeshOptimizeStats& stats = report.optimize;
+    PackScratch scratch;
 
-    for (unsigned int i = 0; i < aiMesh->mNumVertices; i++)
+    // Full levels of every mesh; the simplified ones add at most as much again
+    size_t vertexFloats = 0;
+    size_t indexCount = 0;
+    for (unsigned int i = 0; i < scene->mNumMeshes; i++)
     {
-        mesh.vertices.push_back(aiMesh->mVertices[i].x);
-        mesh.vertices.push_back(aiMesh->mVertices[i].y);
-        mesh.vertices.push_back(aiMesh->mVertices[i].z);
+        vertexFloats += (size_t)scene->mMeshes[i]->mNumVertices * MODEL_VERTEX_FLOATS;
+        indexCount += (size_t)scene->mMeshes[i]->mNumFaces * 3;
+    }
+    mesh.vertices.reserve(vertexFloats);
+    mesh.indices.reserve(indexCount * 2);
 
-        mesh.vertices.push_back(aiMesh->mNormals[i].x);
-        mesh.vertices.push_back(aiMesh->mNormals[i].y);
-        mesh.vertices.push_back(aiMesh->mNormals[i].z);
+    // Depth-first walk of the node tree; a node is pushed after its parent
+    std::vector<std::pair<const aiNode*, int> > stack;
+    stack.push_back(std::make_pair(scene->mRootNode, -1));
+    while (!stack.empty())
+    {
+        const aiNode* source = stack.back().first;
+        int parent = stack.back().second;
+        stack.pop_back();
+
+        ModelNode node;
+        node.name = source->mName.C_Str();
+        node.parent = parent;
+        node.local = toMat4(source->mTransformation);
+        node.world = parent < 0 ? node.local : mesh.nodes[parent].world * node.local;
+        int nodeIndex = (int)mesh.nodes.size();
+        mesh.nodes.push_back(node);
 
-        if (aiMesh->mTextureCoords[0])
+        for (unsigned int i = 0; i < source->mNumMeshes; i++)
         {
-            mesh.vertices.push_back(aiMesh->mTextureCoords[0][i].x);
-            mesh.vertices.push_back(aiMesh->mTextureCoords[0][i].y);
+            unsigned int meshIndex = source->mMeshes[i];
+            if (packed[meshIndex] < 0)
+            {
+                packed[meshIndex] = (int)meshRanges.size();
+                meshRanges.push_back(packMesh(scene->mMeshes[meshIndex], mesh, options, scratch, stats));
+            }
+
+            Submesh submesh = meshRanges[packed[meshIndex]];
+            submesh.node = nodeIndex;
+            mesh.submeshes.push_back(submesh);
         }
-        else
+
+        for (unsigned int i = source->mNumChildren; i > 0; i--)
+            stack.push_back(std::make_pair(source->mChildren[i - 1], nodeIndex));
+    }
+    importer.FreeScene();
+
+    report.imported = true;
+    report.meshletCount = mesh.meshlets.size();
+
+    // Model bounds: union of the submesh boxes placed by their nodes
+    for (size_t i = 0; i < mesh.submeshes.size(); i++)
+    {
+        const Submesh& submesh = mesh.submeshes[i];
+        AABB box = transformBox(submesh.bounds.box, mesh.nodes[submesh.node].world);
+        if (i == 0)
+        {
+            mesh.bounds.box = box;
+            continue;
+        }
+        mesh.bounds.box.min = Vector3(fminf(mesh.bounds.box.min.x, box.min.x), fminf(mesh.bounds.box.min.y, box.min.y), fminf(mesh.bounds.box.min.z, box.min.z));
+        mesh.bounds.box.max = Vector3(fmaxf(mesh.bounds.box.max.x, box.max.x), fmaxf(mesh.bounds.box.max.y, box.max.y), fmaxf(mesh.bounds.box.max.z, box.max.z));
+    }
+    Vector3 extent = (mesh.bounds.box.max - mesh.bounds.box.min) * 0.5f;
+    mesh.bounds.sphere.center = (mesh.bounds.box.min + mesh.bounds.box.max) * 0.5f;
+    mesh.bounds.sphere.radius = sqrtf(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+
+    return true;
+}
+
+// Model-level LOD errors: every submesh's error scaled by the largest axis
+// scale of its node, maxed per level
+static void computeLodErrors(Mesh& mesh)
+{
+    mesh.lodCount = 1;
+    for (unsigned int level = 0; level < MAX_LODS; level++)
+        mesh.lodErrors[level] = 0.0f;
+
+    for (size_t i = 0; i < mesh.submeshes.size(); i++)
+    {
+        const Submesh& submesh = mesh.submeshes[i];
+        float scale = maxAxisScale(mesh.nodes[submesh.node].world.m);
+
+        mesh.lodCount = std::max(mesh.lodCount, submesh.lodCount);
+        for (unsigned int level = 0; level < MAX_LODS; level++)
+        {
+            const LodLevel& lod = submesh.lods[std::min(level, submesh.lodCount - 1)];
+            mesh.lodErrors[level] = fmaxf(mesh.lodErrors[level], lod.error * scale);
+        }
+    }
+}
+
+// Snorm quantization of v in [-1, 1] to bits bits
+static int quantizeSnorm(float v, int bits)
+{
+    float scale = (float)((1 << (bits - 1)) - 1);
+    v = fminf(fmaxf(v, -1.0f), 1.0f);
+    return (int)(v * scale + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+// Pack float vertices as QuantizedVertex; the position box and UV range used
+// are stored in the mesh for the shader
+static std::vector<QuantizedVertex> quantizeVertices(Mesh& mesh, const float* vertices, size_t vertexCount)
+{
+    Bounds bounds = computeBounds(vertices, vertexCount, MODEL_VERTEX_FLOATS);
+    Vector3 center = (bounds.box.min + bounds.box.max) * 0.5f;
+    Vector3 extent = (bounds.box.max - bounds.box.min) * 0.5f;
+    float scale[3] = { extent.x, extent.y, extent.z };
+
+    float uvMin[2] = { 0.0f, 0.0f };
+    float uvMax[2] = { 0.0f, 0.0f };
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* uv = vertices + i * MODEL_VERTEX_FLOATS + 6;
+        for (int c = 0; c < 2; c++)
         {
-            mesh.vertices.push_back(0.0f);
-            mesh.vertices.push_back(0.0f);
+            uvMin[c] = (i == 0) ? uv[c] : fminf(uvMin[c], uv[c]);
+            uvMax[c] = (i == 0) ? uv[c] : fmaxf(uvMax[c], uv[c]);
         }
     }
+    float uvScale[2] = { uvMax[0] - uvMin[0], uvMax[1] - uvMin[1] };
+
+    // A flat axis keeps a unit scale so the division below stays finite
+    for (int c = 0; c < 3; c++)
+        scale[c] = (scale[c] > 0.0f) ? scale[c] : 1.0f;
+    for (int c = 0; c < 2; c++)
+        uvScale[c] = (uvScale[c] > 0.0f) ? uvScale[c] : 1.0f;
 
-    for (unsigned int i = 0; i < aiMesh->mNumFaces; i++)
+    mesh.positionOffset[0] = center.x;
+    mesh.positionOffset[1] = center.y;
+    mesh.positionOffset[2] = center.z;
+    for (int c = 0; c < 3; c++)
+        mesh.positionScale[c] = scale[c];
+    mesh.texCoordTransform[0] = uvMin[0];
+    mesh.texCoordTransform[1] = uvMin[1];
+    mesh.texCoordTransform[2] = uvScale[0];
+    mesh.texCoordTransform[3] = uvScale[1];
+
+    std::vector<QuantizedVertex> result(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
     {
-        aiFace face = aiMesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
+        const float* v = vertices + i * MODEL_VERTEX_FLOATS;
+        QuantizedVertex& q = result[i];
+
+        for (int c = 0; c < 3; c++)
+            q.position[c] = (int16_t)quantizeSnorm((v[c] - mesh.positionOffset[c]) / scale[c], 16);
+        q.position[3] = 0;
+
+        float length = sqrtf(v[3] * v[3] + v[4] * v[4] + v[5] * v[5]);
+        float inverse = (length > 0.0f) ? 1.0f / length : 0.0f;
+        uint32_t nx = (uint32_t)quantizeSnorm(v[3] * inverse, 10) & 0x3FF;
+        uint32_t ny = (uint32_t)quantizeSnorm(v[4] * inverse, 10) & 0x3FF;
+        uint32_t nz = (uint32_t)quantizeSnorm(v[5] * inverse, 10) & 0x3FF;
+        q.normal = nx | (ny << 10) | (nz << 20);
+
+        for (int c = 0; c < 2; c++)
         {
-            mesh.indices.push_back(face.mIndices[j]);
+            float t = fminf(fmaxf((v[6 + c] - uvMin[c]) / uvScale[c], 0.0f), 1.0f);
+            q.texCoord[c] = (uint16_t)(t * 65535.0f + 0.5f);
         }
     }
+    return result;
+}
+
+void prepareMeshUpload(Mesh& mesh, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+    MeshUploadData& data)
+{
+    data.vertices = vertices;
+    data.indices = indices;
+    data.packedVertices.clear();
+    data.narrowIndices.clear();
 
+    // Identity dequantization unless the vertices are packed below
+    for (int c = 0; c < 3; c++)
+    {
+        mesh.positionOffset[c] = 0.0f;
+        mesh.positionScale[c] = 1.0f;
+    }
+    mesh.texCoordTransform[0] = 0.0f;
+    mesh.texCoordTransform[1] = 0.0f;
+    mesh.texCoordTransform[2] = 1.0f;
+    mesh.texCoordTransform[3] = 1.0f;
+
+    if (mesh.format == VERTEX_FORMAT_QUANTIZED)
+    {
+        data.packedVertices = quantizeVertices(mesh, vertices, vertexCount);
+        data.vertexBytes = vertexCount * sizeof(QuantizedVertex);
+    }
+    else
+    {
+        data.vertexBytes = vertexCount * MODEL_VERTEX_FLOATS * sizeof(float);
+    }
+
+    // Indices are relative to their submesh's baseVertex, so a large model
+    // can still use 16-bit indices if no single mesh exceeds 65536 vertices
+    unsigned int maxIndex = 0;
+    for (size_t i = 0; i < indexCount; i++)
+        maxIndex = (indices[i] > maxIndex) ? indices[i] : maxIndex;
+
+    if (maxIndex <= 0xFFFF)
+    {
+        data.narrowIndices.assign(indices, indices + indexCount);
+        data.indexBytes = indexCount * sizeof(uint16_t);
+        mesh.indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        data.indexBytes = indexCount * sizeof(unsigned int);
+        mesh.indexType = GL_UNSIGNED_INT;
+    }
+}
+
+void createMeshBuffers(Mesh& mesh, const MeshUploadData& data, bool fill)
+{
     glGenVertexArrays(1, &mesh.VAO);
     glGenBuffers(1, &mesh.VBO);
     glGenBuffers(1, &mesh.EBO);
+    mesh.vertexBytes = (GLsizeiptr)data.vertexBytes;
+    mesh.indexBytes = (GLsizeiptr)data.indexBytes;
+
+    glState.bindVertexArray(mesh.VAO);
 
-    glBindVertexArray(mesh.VAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertexBytes, fill ? data.vertexData() : NULL, GL_STATIC_DRAW);
+    if (mesh.format == VERTEX_FORMAT_QUANTIZED)
+    {
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, normal));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, texCoord));
+    }
+    else
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, MODEL_VERTEX_FLOATS * sizeof(float), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, MODEL_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, MODEL_VERTEX_FLOATS * sizeof(float), (void*)(6 * sizeof(float)));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
 
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indexBytes, fill ? data.indexData() : NULL, GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.bindVertexArray(0);
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+void uploadMesh(Mesh& mesh, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+    MeshUploadData data;
+    prepareMeshUpload(mesh, vertices, vertexCount, indices, indexCount, data);
+    createMeshBuffers(mesh, data, true);
+}
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+void destroyMeshBuffers(Mesh& mesh)
+{
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh.VAO = mesh.VBO = mesh.EBO = 0;
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // GL unbinds deleted objects and may hand their names out again
+    glState.invalidate();
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void releaseCpuData(Mesh& mesh)
+{
+    std::vector<float>().swap(mesh.vertices);
+    std::vector<unsigned int>().swap(mesh.indices);
+}
+
+// The .mesh cache when it is up to date, else an import that rewrites it;
+// shared by readModel and ModelLoader::loadModel. With upload, a cache hit
+// goes to the GPU straight from the mapped file and mesh.VAO is set; an
+// import is always left in mesh.vertices and mesh.indices.
+static bool readOrImport(const std::string& path, unsigned int options, Mesh& mesh, Assimp::Importer* importer, bool upload,
+    ModelImportReport& report)
+{
+    report = ModelImportReport();
+    VertexFormat format = mesh.format;
+    mesh = Mesh();
+    mesh.format = format;
+
+    uint64_t key = 0;
+    bool keyed = meshCacheKey(path, MODEL_IMPORT_FLAGS, options, key);
+    std::string cachePath = meshCachePath(path);
+
+    if (!keyed || !loadMeshCache(cachePath, key, mesh, upload))
+    {
+        mesh = Mesh();
+        mesh.format = format;
+        // A fresh importer registers every format loader, which is not cheap
+        std::unique_ptr<Assimp::Importer> localImporter;
+        if (!importer)
+        {
+            localImporter.reset(new Assimp::Importer());
+            importer = localImporter.get();
+        }
+        if (!importModel(path, options, mesh, *importer, report))
+            return false;
+        if (keyed)
+            writeMeshCache(cachePath, key, mesh);
+    }
 
-    mesh.textureID = loadTexture(texturePath);
+    computeLodErrors(mesh);
+    return true;
+}
+
+bool readModel(const std::string& path, unsigned int options, Mesh& mesh, Assimp::Importer* importer,
+    ModelImportReport* report)
+{
+    ModelImportReport localReport;
+    return readOrImport(path, options, mesh, importer, false, report ? *report : localReport);
+}
+
+Mesh ModelLoader::loadModel(const std::string& path, const std::string& texturePath)
+{
+    Mesh mesh = {};
+    mesh.format = vertexFormat;
+    unsigned int options = buildMeshlets ? MODEL_OPTION_MESHLETS : 0;
+
+    // A kept copy is read out of the cache, then uploaded like an import
+    ModelImportReport report;
+    if (!readOrImport(path, options, mesh, NULL, !keepCpuData, report))
+        return {};
+    report.print(std::cout, path);
+    if (!mesh.VAO)
+        uploadMesh(mesh, mesh.vertices.data(), mesh.vertices.size() / MODEL_VERTEX_FLOATS, mesh.indices.data(), mesh.indices.size());
+    if (!keepCpuData)
+        releaseCpuData(mesh);
+
+    if (!texturePath.empty())
+        mesh.textureID = loadTexture(texturePath);
 
     return mesh;
 }
+
+void ModelImportReport::print(std::ostream& out, const std::string& path) const
+{
+    if (!imported)
+        return;
+    out << "Optimized " << path << ": " << optimize.verticesBefore << " -> " << optimize.verticesAfter << " vertices, ACMR "
+        << optimize.before.acmr() << " -> " << optimize.after.acmr() << ", ATVR "
+        << optimize.before.atvr() << " -> " << optimize.after.atvr() << std::endl;
+    if (meshletCount > 0)
+        out << "Meshlets " << path << ": " << meshletCount << std::endl;
+}
+
+void appendDrawCommands(const Mesh& mesh, GLuint firstNodeInstance, std::vector<DrawElementsIndirectCommand>& commands,
+    unsigned int lod)
+{
+    for (size_t i = 0; i < mesh.submeshes.size(); i++)
+    {
+        const Submesh& submesh = mesh.submeshes[i];
+        const LodLevel& level = submesh.lods[std::min(lod, submesh.lodCount - 1)];
+        DrawElementsIndirectCommand command;
+        command.count = (GLuint)level.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = level.firstIndex;
+        command.baseVertex = level.baseVertex;
+        command.baseInstance = firstNodeInstance + (GLuint)submesh.node;
+        commands.push_back(command);
+    }
+}
+
+// World-space meshlet spheres of one submesh, reused between calls
+static std::vector<float> meshletX, meshletY, meshletZ, meshletRadius;
+static std::vector<unsigned char> meshletVisible;
+
+void appendVisibleMeshlets(const Mesh& mesh, const Mat4& model, const Frustum& frustum, const Vector3& eye,
+    GLuint firstNodeInstance, std::vector<DrawElementsIndirectCommand>& commands, MeshletCullStats* stats)
+{
+    for (size_t i = 0; i < mesh.submeshes.size(); i++)
+    {
+        const Submesh& submesh = mesh.submeshes[i];
+        DrawElementsIndirectCommand command;
+        command.instanceCount = 1;
+        command.baseVertex = submesh.baseVertex;
+        command.baseInstance = firstNodeInstance + (GLuint)submesh.node;
+        if (submesh.meshletCount == 0)
+        {
+            command.count = (GLuint)submesh.indexCount;
+            command.firstIndex = submesh.firstIndex;
+            commands.push_back(command);
+            continue;
+        }
+
+        Mat4 world = model * mesh.nodes[submesh.node].world;
+
+        meshletX.resize(submesh.meshletCount);
+        meshletY.resize(submesh.meshletCount);
+        meshletZ.resize(submesh.meshletCount);
+        meshletRadius.resize(submesh.meshletCount);
+        meshletVisible.resize(submesh.meshletCount);
+        for (GLuint j = 0; j < submesh.meshletCount; j++)
+        {
+            BoundingSphere sphere = transformSphere(mesh.meshlets[submesh.firstMeshlet + j].sphere, world.m);
+            meshletX[j] = sphere.center.x;
+            meshletY[j] = sphere.center.y;
+            meshletZ[j] = sphere.center.z;
+            meshletRadius[j] = sphere.radius;
+        }
+        cullSpheres(frustum, meshletX.data(), meshletY.data(), meshletZ.data(), meshletRadius.data(),
+            submesh.meshletCount, meshletVisible.data());
+
+        // Which side of a plane the eye is on survives any affine transform,
+        // so the cone test runs in the node's space with no cone to transform
+        Vector4 localEye = Mat4::affineInverse(world) * Vector4(eye.x, eye.y, eye.z, 1.0f);
+        Vector3 eyeInNode(localEye.x, localEye.y, localEye.z);
+
+        command.count = 0;
+        for (GLuint j = 0; j < submesh.meshletCount; j++)
+        {
+            const Meshlet& meshlet = mesh.meshlets[submesh.firstMeshlet + j];
+            bool visible = meshletVisible[j] != 0;
+            bool backfacing = visible && meshletBackfacing(meshlet, eyeInNode);
+            if (stats)
+            {
+                stats->tested++;
+                stats->frustumCulled += visible ? 0 : 1;
+                stats->backfaceCulled += backfacing ? 1 : 0;
+            }
+            if (!visible || backfacing)
+                continue;
+
+            if (command.count > 0 && command.firstIndex + command.count == meshlet.firstIndex)
+            {
+                command.count += (GLuint)meshlet.indexCount;
+                continue;
+            }
+            if (command.count > 0)
+                commands.push_back(command);
+            command.firstIndex = meshlet.firstIndex;
+            command.count = (GLuint)meshlet.indexCount;
+        }
+        if (command.count > 0)
+            commands.push_back(command);
+    }
+}
@@ -4,21 +4,195 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <glad/glad.h>
+#include "Bounds.h"
+#include "Frustum.h"
+#include "Lod.h"
+#include "Mat4.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "RenderQueue.h"
 
 
 #include <iostream>
 
+const int MODEL_VERTEX_FLOATS = 8;  // Position, normal, texture coordinates
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals;
+
+// Import options beyond the Assimp flags; part of the .mesh cache key
+const unsigned int MODEL_OPTION_MESHLETS = 1;  // Split the full detail level of every mesh into meshlets
+
+// Layout of a model's vertex buffer on the GPU
+enum VertexFormat {
+    VERTEX_FORMAT_FLOAT = 0,  // MODEL_VERTEX_FLOATS floats, 32 bytes
+    VERTEX_FORMAT_QUANTIZED   // QuantizedVertex, 16 bytes
+};
+
+// Compact vertex: position as snorm16 inside the model's box, normal as
+// snorm 10:10:10:2 and texture coordinates as unorm16 inside the model's UV
+// range. The Mesh's dequantization parameters map position and UVs back;
+// writeModelNodes folds them into the per-node instance data.
+struct QuantizedVertex {
+    int16_t position[4];  // w unused, keeps the normal 4-byte aligned
+    uint32_t normal;      // GL_INT_2_10_10_10_REV
+    uint16_t texCoord[2];
+};
+
+// Node of the imported scene graph. Parents come before their children.
+struct ModelNode {
+    std::string name;
+    int parent;  // -1 for the root
+    Mat4 local;  // Relative to the parent
+    Mat4 world;  // Relative to the model origin
+};
+
+struct ModelMaterial {
+    std::string name;
+    float diffuse[4];
+    std::string diffuseTexture;  // As stored in the file, empty if none
+};
+
+// One mesh reference of one node: a range of the packed buffers. A mesh used
+// by several nodes is stored once and referenced by several submeshes.
+// Its simplified levels follow the full index range in the same index
+// buffer and share its vertices.
+struct Submesh {
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLsizei indexCount;
+    unsigned int materialId;
+    int node;       // Index in Mesh::nodes, whose world matrix places the submesh
+    Bounds bounds;  // Local to the node
+    unsigned int lodCount;
+    LodLevel lods[MAX_LODS];  // lods[0] is the full range above
+    GLuint firstMeshlet;      // Meshlets tiling the full range, in Mesh::meshlets
+    GLuint meshletCount;      // 0 unless imported with MODEL_OPTION_MESHLETS
+};
+
+// Every mesh of a model packed into one VAO/VBO/EBO. vertices and indices
+// are the CPU copy, released after the upload unless the loader was asked
+// to keep it (keepCpuData) for collision or picking. A model loaded from its
+// .mesh cache is uploaded straight from the mapped file and only copied when
+// kept. The CPU copy is always float vertices and 32-bit indices, whatever
+// format went to the GPU.
 struct Mesh {
     GLuint VAO, VBO, EBO, textureID;
+    VertexFormat format;
+    GLenum indexType;               // GL_UNSIGNED_SHORT when every index fits in 16 bits
+    GLsizeiptr vertexBytes;         // Sizes of VBO and EBO
+    GLsizeiptr indexBytes;
+    float positionOffset[3];        // Dequantization: position = offset + scale * attribute
+    float positionScale[3];
+    float texCoordTransform[4];     // UV offset in xy, scale in zw
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
+    std::vector<Submesh> submeshes;
+    std::vector<ModelNode> nodes;
+    std::vector<ModelMaterial> materials;
+    std::vector<Meshlet> meshlets;  // firstIndex made absolute in the index buffer
+    Bounds bounds;  // Whole model in model space, for culling
+    unsigned int lodCount;       // Levels of the most detailed submesh
+    float lodErrors[MAX_LODS];   // Per level, the largest submesh error in model space
 };
 
+// Loads from the cooked .mesh next to path when it is up to date (see
+// MeshCache.h), otherwise imports with Assimp and writes the cache
 class ModelLoader {
 public:
-    Mesh loadModel(const std::string& path, const std::string& texturePath);
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    bool buildMeshlets = false;  // MODEL_OPTION_MESHLETS
+    bool keepCpuData = false;    // Keep Mesh::vertices and Mesh::indices after the upload
+
+    Mesh loadModel(const std::string& path, const std::string& texturePath);  // texturePath may be empty
+};
+
+// GPU-ready vertex and index bytes of a mesh. Converted data lives in the
+// vectors; otherwise the source arrays are uploaded as they are.
+struct MeshUploadData {
+    const float* vertices = NULL;
+    const unsigned int* indices = NULL;
+    std::vector<QuantizedVertex> packedVertices;
+    std::vector<uint16_t> narrowIndices;
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+
+    const void* vertexData() const { return packedVertices.empty() ? (const void*)vertices : (const void*)packedVertices.data(); }
+    const void* indexData() const { return narrowIndices.empty() ? (const void*)indices : (const void*)narrowIndices.data(); }
 };
 
+// Convert packed float vertices and 32-bit indices to mesh.format and the
+// narrowest index type, and set mesh.indexType and the dequantization
+// parameters. No GL calls, so it can run on a worker thread.
+void prepareMeshUpload(Mesh& mesh, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+    MeshUploadData& data);
+
+// Create the VAO, VBO and EBO of mesh for data, with the attribute layout of
+// mesh.format. Without fill the buffers are allocated but left undefined,
+// for uploads spread over several frames.
+void createMeshBuffers(Mesh& mesh, const MeshUploadData& data, bool fill);
+
+// prepareMeshUpload and createMeshBuffers in one go
+void uploadMesh(Mesh& mesh, const float* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+
+// Delete the VAO, VBO and EBO of mesh; its texture is left alone
+void destroyMeshBuffers(Mesh& mesh);
+
+// Free mesh.vertices and mesh.indices once the GPU has its copy
+void releaseCpuData(Mesh& mesh);
+
+// What an import did to a model, filled on the thread that imports and
+// printed by the thread that owns the output. Empty for a cache hit.
+struct ModelImportReport {
+    bool imported = false;
+    MeshOptimizeStats optimize;
+    size_t meshletCount = 0;
+
+    void print(std::ostream& out, const std::string& path) const;  // Nothing for a cache hit
+};
+
+// CPU half of loadModel, safe on any thread: read the .mesh cache or import
+// (writing the cache) into mesh.vertices, mesh.indices and the tables.
+// mesh.format is kept; nothing is uploaded. importer, if given, is reused
+// instead of a fresh one; it must not be shared between threads. Nothing is
+// printed on success; an import fills report, if given.
+bool readModel(const std::string& path, unsigned int options, Mesh& mesh, Assimp::Importer* importer = NULL,
+    ModelImportReport* report = NULL);
+
+// Decoded image, owned by stb_image until freeTexture
+struct TextureImage {
+    unsigned char* pixels;
+    int width, height, channels;
+};
+
+bool decodeTexture(const std::string& path, TextureImage& image);  // No GL calls
+void freeTexture(TextureImage& image);
+GLuint createTexture(const TextureImage& image);  // Mipmapped; image is left to the caller
+GLuint loadTexture(const std::string& path);
+
+// Append one indirect command per submesh so the whole model is one
+// multi-draw on mesh.VAO. baseInstance is the submesh's node index plus
+// firstNodeInstance, so each draw fetches its node's transform from the
+// instance data of writeModelNodes.
+// lod picks the detail level (see selectLod with mesh.lodErrors); submeshes
+// with fewer levels use their coarsest one.
+void appendDrawCommands(const Mesh& mesh, GLuint firstNodeInstance, std::vector<DrawElementsIndirectCommand>& commands,
+    unsigned int lod = 0);
+
+struct MeshletCullStats {
+    size_t tested = 0;
+    size_t frustumCulled = 0;
+    size_t backfaceCulled = 0;
+};
+
+// Full-detail counterpart of appendDrawCommands for a model placed by model:
+// meshlets outside frustum or facing away from eye (world space) are dropped
+// and every run of adjacent visible meshlets becomes one command. Submeshes
+// without meshlets are appended whole. The cone test assumes closed,
+// counter-clockwise geometry, whose back faces are never seen.
+void appendVisibleMeshlets(const Mesh& mesh, const Mat4& model, const Frustum& frustum, const Vector3& eye,
+    GLuint firstNodeInstance, std::vector<DrawElementsIndirectCommand>& commands, MeshletCullStats* stats = NULL);
+
 #endif
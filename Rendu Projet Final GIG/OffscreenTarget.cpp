@@ -0,0 +1,127 @@
+#include "OffscreenTarget.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool OffscreenTarget::create(int targetWidth, int targetHeight)
+{
+    width = targetWidth;
+    height = targetHeight;
+
+    glCreateRenderbuffers(1, &color);
+    glNamedRenderbufferStorage(color, GL_RGBA8, width, height);
+    glCreateRenderbuffers(1, &depth);
+    glNamedRenderbufferStorage(depth, GL_DEPTH24_STENCIL8, width, height);
+
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    GLenum status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Offscreen framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void OffscreenTarget::destroy()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    framebuffer = color = depth = 0;
+}
+
+// Color attachment as RGB bytes, top row first like a PPM
+void OffscreenTarget::readPixels(std::vector<unsigned char>& pixels) const
+{
+    std::vector<unsigned char> rows((size_t)width * height * 3);
+
+    // Read into client memory, not into whatever pack buffer is bound
+    glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glNamedFramebufferReadBuffer(framebuffer, GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+
+    // GL rows start at the bottom
+    size_t rowBytes = (size_t)width * 3;
+    pixels.resize(rows.size());
+    for (int y = 0; y < height; y++)
+        memcpy(&pixels[(size_t)y * rowBytes], &rows[(size_t)(height - 1 - y) * rowBytes], rowBytes);
+}
+
+bool OffscreenTarget::writePpm(const char* path) const
+{
+    std::vector<unsigned char> pixels;
+    readPixels(pixels);
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        std::cerr << "Failed to write frame dump: " << path << std::endl;
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    fwrite(pixels.data(), 1, pixels.size(), file);
+    fclose(file);
+    return true;
+}
+
+bool OffscreenTarget::comparePpm(const char* path, std::ostream& out) const
+{
+    FILE* file = fopen(path, "rb");
+    int fileWidth = 0, fileHeight = 0, maxValue = 0;
+    if (!file || fscanf(file, "P6 %d %d %d", &fileWidth, &fileHeight, &maxValue) != 3 || fgetc(file) == EOF
+        || fileWidth != width || fileHeight != height || maxValue != 255)
+    {
+        std::cerr << "Not a " << width << "x" << height << " frame dump: " << path << std::endl;
+        if (file)
+            fclose(file);
+        return false;
+    }
+    std::vector<unsigned char> reference((size_t)width * height * 3);
+    size_t read = fread(reference.data(), 1, reference.size(), file);
+    fclose(file);
+    if (read != reference.size())
+    {
+        std::cerr << "Truncated frame dump: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> pixels;
+    readPixels(pixels);
+
+    int maxDifference = 0;
+    size_t differentPixels = 0;
+    double squaredError = 0.0;
+    for (size_t i = 0; i < pixels.size(); i += 3)
+    {
+        int pixelDifference = 0;
+        for (size_t c = 0; c < 3; c++)
+        {
+            int difference = abs((int)pixels[i + c] - (int)reference[i + c]);
+            pixelDifference = std::max(pixelDifference, difference);
+            squaredError += (double)difference * difference;
+        }
+        maxDifference = std::max(maxDifference, pixelDifference);
+        differentPixels += (pixelDifference > 0) ? 1 : 0;
+    }
+
+    double meanSquaredError = squaredError / pixels.size();
+    out << "Frame against " << path << ": " << differentPixels << " of " << (size_t)width * height
+        << " pixels differ, largest difference " << maxDifference << "/255, PSNR ";
+    if (meanSquaredError > 0.0)
+        out << 10.0 * log10(255.0 * 255.0 / meanSquaredError) << " dB" << std::endl;
+    else
+        out << "infinite (identical)" << std::endl;
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef OFFSCREENTARGET_H
+#define OFFSCREENTARGET_H
+
+#include <glad/glad.h>
+#include <ostream>
+#include <vector>
+
+// Framebuffer object with a color and a depth renderbuffer, used to render
+// without a visible window (headless benchmark runs)
+struct OffscreenTarget {
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+    int width = 0;
+    int height = 0;
+
+    bool create(int width, int height);
+    void destroy();
+
+    // Read the color attachment back and write it as a binary PPM (P6)
+    bool writePpm(const char* path) const;
+
+    // Read the color attachment back and print how far it is from a frame
+    // written by writePpm: pixels that differ, largest channel difference
+    // and PSNR. False if path is not a dump of the same size.
+    bool comparePpm(const char* path, std::ostream& out) const;
+
+private:
+    void readPixels(std::vector<unsigned char>& pixels) const;
+};
+
+#endif
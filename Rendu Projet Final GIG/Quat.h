@@ -0,0 +1,37 @@
+#ifndef QUAT_H
+#define QUAT_H
+
+#include "ConstMath.h"
+#include "Vector3.h"
+
+// Unit quaternion rotation
+struct Quat {
+    float x, y, z, w;
+
+    constexpr Quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    constexpr Quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    // Rotation of angle radians around a unit axis
+    static constexpr Quat fromAxisAngle(const Vector3& axis, float angle)
+    {
+        float s = constSin(angle * 0.5f);
+        return Quat(axis.x * s, axis.y * s, axis.z * s, constCos(angle * 0.5f));
+    }
+
+    // Rotation by other first, then by this
+    constexpr Quat operator*(const Quat& o) const
+    {
+        return Quat(w * o.x + x * o.w + y * o.z - z * o.y,
+            w * o.y - x * o.z + y * o.w + z * o.x,
+            w * o.z + x * o.y - y * o.x + z * o.w,
+            w * o.w - x * o.x - y * o.y - z * o.z);
+    }
+
+    constexpr Quat normalized() const
+    {
+        float inv = 1.0f / constSqrt(x * x + y * y + z * z + w * w);
+        return Quat(x * inv, y * inv, z * inv, w * inv);
+    }
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+
+uint64_t makeSortKey(unsigned int pass, GLuint program, unsigned int material, GLuint vertexArray, float depth)
+{
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    uint64_t quantizedDepth = (uint64_t)(depth * (float)((1u << 28) - 1));
+
+    return ((uint64_t)(pass & 0xF) << 60)
+        | ((uint64_t)(program & 0xFF) << 52)
+        | ((uint64_t)(material & 0xFFF) << 40)
+        | ((uint64_t)(vertexArray & 0xFFF) << 28)
+        | quantizedDepth;
+}
+
+void RenderQueue::clear()
+{
+    keys.clear();
+    order.clear();
+    commands.clear();
+}
+
+void RenderQueue::submit(uint64_t key, const DrawCommand& command)
+{
+    keys.push_back(key);
+    order.push_back((uint32_t)commands.size());
+    commands.push_back(command);
+}
+
+// LSD radix sort on 8-bit digits, stable, skipping digits every key shares
+void RenderQueue::sort()
+{
+    size_t count = keys.size();
+    if (count < 2)
+        return;
+
+    sortedKeys.resize(count);
+    sortedOrder.resize(count);
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+            histogram[(keys[i] >> shift) & 0xFF]++;
+
+        if (histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            size_t bucket = histogram[digit];
+            histogram[digit] = offset;
+            offset += bucket;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+            sortedKeys[destination] = keys[i];
+            sortedOrder[destination] = order[i];
+        }
+
+        keys.swap(sortedKeys);
+        order.swap(sortedOrder);
+    }
+}
+
+bool RenderQueue::sameBatch(const DrawCommand& a, const DrawCommand& b) const
+{
+    return mergeBatches
+        && a.indexed && b.indexed
+        && a.program == b.program
+        && a.VAO == b.VAO
+        && a.indexType == b.indexType
+        && a.texture == b.texture
+        && a.depthFunc == b.depthFunc;
+}
+
+void RenderQueue::flush(RingBuffer& stream, GpuProfiler* profiler)
+{
+    size_t indexedCount = 0;
+    for (size_t i = 0; i < commands.size(); i++)
+    {
+        if (commands[i].indexed)
+            indexedCount++;
+    }
+
+    // Every indexed draw gets its indirect command in sorted order
+    GLintptr indirectOffset = 0;
+    if (indexedCount > 0)
+    {
+        RingAllocation allocation = stream.allocate(indexedCount * sizeof(DrawElementsIndirectCommand), sizeof(GLuint));
+        if (!allocation.data)
+            return;
+
+        DrawElementsIndirectCommand* draw = (DrawElementsIndirectCommand*)allocation.data;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const DrawCommand& command = commands[order[i]];
+            if (!command.indexed)
+                continue;
+
+            draw->count = command.count;
+            draw->instanceCount = command.instanceCount;
+            draw->firstIndex = command.firstIndex;
+            draw->baseVertex = command.baseVertex;
+            draw->baseInstance = command.baseInstance;
+            draw++;
+        }
+
+        indirectOffset = allocation.offset;
+        glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.buffer);
+    }
+
+    drawCalls = 0;
+    size_t indirectIndex = 0;
+    size_t i = 0;
+    while (i < order.size())
+    {
+        const DrawCommand& command = commands[order[i]];
+
+        glState.useProgram(command.program);
+        glState.depthFunc(command.depthFunc);
+        if (command.texture)
+            glState.bindTexture(0, command.textureTarget, command.texture);
+        glState.bindVertexArray(command.VAO);
+
+        if (profiler)
+            profiler->begin(mergeBatches ? command.group : command.label);
+
+        if (command.indexed)
+        {
+            size_t end = i + 1;
+            while (end < order.size() && sameBatch(command, commands[order[end]]))
+                end++;
+
+            GLsizei drawCount = (GLsizei)(end - i);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, command.indexType,
+                (void*)(indirectOffset + indirectIndex * sizeof(DrawElementsIndirectCommand)), drawCount, 0);
+
+            indirectIndex += drawCount;
+            i = end;
+        }
+        else
+        {
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, command.firstIndex, command.count, command.instanceCount, command.baseInstance);
+            i++;
+        }
+
+        if (profiler)
+            profiler->end();
+        drawCalls++;
+    }
+}
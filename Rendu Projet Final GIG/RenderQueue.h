@@ -0,0 +1,77 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <glad/glad.h>
+#include "GpuProfiler.h"
+#include "RingBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Passes in draw order; the skybox goes last so it is only shaded where no
+// opaque object wrote depth
+enum RenderPass {
+    PASS_OPAQUE = 0,
+    PASS_SKYBOX = 1
+};
+
+// 64-bit sort key, most significant field first:
+// pass (4) | program (8) | material (12) | vertex array (12) | depth (28)
+// depth is in [0, 1], nearest first
+uint64_t makeSortKey(unsigned int pass, GLuint program, unsigned int material, GLuint vertexArray, float depth);
+
+struct DrawCommand {
+    GLuint program;
+    GLuint VAO;
+    GLenum textureTarget;
+    GLuint texture;     // Bound to unit 0 when non-zero
+    GLenum depthFunc;
+    bool indexed;       // Indices from the VAO's element buffer, else plain arrays
+    GLenum indexType;   // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+    GLsizei count;      // Index or vertex count
+    GLsizei instanceCount;
+    GLuint firstIndex;  // First index or first vertex
+    GLint baseVertex;
+    GLuint baseInstance;
+    const char* label;  // GPU profiler section when batches are not merged
+    const char* group;  // GPU profiler section of a merged batch
+};
+
+// Layout of one glMultiDrawElementsIndirect command
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Collects the frame's draws, radix-sorts them by key and issues them so
+// state changes only happen where the key changes. Consecutive indexed draws
+// sharing program, VAO, texture and depth function are merged into one
+// glMultiDrawElementsIndirect call. With mergeBatches off every command is
+// issued (and timed, when a profiler is given) on its own.
+struct RenderQueue {
+    bool mergeBatches = true;
+    unsigned int drawCalls = 0;  // Draw calls issued by the last flush()
+
+    void clear();
+    void submit(uint64_t key, const DrawCommand& command);
+    void sort();
+    void flush(RingBuffer& stream, GpuProfiler* profiler = NULL);  // Indirect commands are streamed through the ring
+
+    size_t size() const { return commands.size(); }
+
+private:
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<DrawCommand> commands;
+
+    // Ping-pong storage for the radix passes, kept between frames
+    std::vector<uint64_t> sortedKeys;
+    std::vector<uint32_t> sortedOrder;
+
+    bool sameBatch(const DrawCommand& a, const DrawCommand& b) const;
+};
+
+#endif
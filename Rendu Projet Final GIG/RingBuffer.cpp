@@ -0,0 +1,91 @@
+#include "RingBuffer.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+void RingBuffer::create(GLsizeiptr bytesPerFrame)
+{
+    regionSize = bytesPerFrame;
+    GLsizeiptr size = regionSize * RING_BUFFER_FRAMES;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, NULL, flags);
+    mapped = (unsigned char*)glMapNamedBufferRange(buffer, 0, size, flags);
+    if (!mapped)
+        std::cerr << "Failed to map ring buffer" << std::endl;
+}
+
+void RingBuffer::destroy()
+{
+    for (int i = 0; i < RING_BUFFER_FRAMES; i++)
+    {
+        if (fences[i])
+            glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+    if (buffer)
+    {
+        glUnmapNamedBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = NULL;
+}
+
+// Move to the next region, waiting until the GPU is done with it
+void RingBuffer::beginFrame()
+{
+    region = (region + 1) % RING_BUFFER_FRAMES;
+    head = 0;
+    frames++;
+
+    GLsync fence = fences[region];
+    if (!fence)
+        return;
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        fenceWaits++;
+        double start = glfwGetTime();
+        do
+        {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+        } while (status == GL_TIMEOUT_EXPIRED);
+        fenceWaitMs += (glfwGetTime() - start) * 1000.0;
+    }
+
+    glDeleteSync(fence);
+    fences[region] = 0;
+}
+
+// Reserve size bytes in this frame's region. alignment need not be a power of
+// two, so instance data can be aligned to its stride and addressed by baseInstance.
+RingAllocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    RingAllocation allocation = { NULL, 0 };
+
+    GLsizeiptr regionStart = regionSize * region;
+    GLsizeiptr offset = regionStart + head;
+    if (alignment > 1)
+        offset = (offset + alignment - 1) / alignment * alignment;
+
+    if (!mapped || offset + size > regionStart + regionSize)
+    {
+        // Only the first failure is printed; this can repeat every draw of every frame
+        if (failedAllocations++ == 0)
+            std::cerr << "Ring buffer region full (" << regionSize << " bytes)" << std::endl;
+        return allocation;
+    }
+
+    head = offset + size - regionStart;
+    allocation.data = mapped + offset;
+    allocation.offset = offset;
+    return allocation;
+}
+
+// Fence everything submitted this frame
+void RingBuffer::endFrame()
+{
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,41 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// Frames the CPU may run ahead of the GPU; each owns one region of the ring
+const int RING_BUFFER_FRAMES = 3;
+
+struct RingAllocation {
+    void* data;        // Write pointer into the persistent mapping, NULL if the region is full
+    GLintptr offset;   // Offset of data from the start of the buffer
+};
+
+// Persistently mapped, coherent buffer split into RING_BUFFER_FRAMES regions.
+// Each frame streams its dynamic data into the next region; a fence placed at
+// endFrame() keeps the CPU from overwriting a region the GPU still reads.
+struct RingBuffer {
+    GLuint buffer = 0;
+    GLsizeiptr regionSize = 0;
+
+    unsigned int frames = 0;
+    unsigned int fenceWaits = 0;   // Frames where beginFrame() blocked on the GPU
+    double fenceWaitMs = 0.0;      // Total time spent blocked
+    unsigned int failedAllocations = 0;  // allocate() calls that found the region full
+
+    void create(GLsizeiptr bytesPerFrame);
+    void destroy();
+
+    void beginFrame();
+    RingAllocation allocate(GLsizeiptr size, GLsizeiptr alignment);
+    void endFrame();
+
+private:
+    unsigned char* mapped = NULL;
+    GLsync fences[RING_BUFFER_FRAMES] = {};
+    int region = 0;
+    GLsizeiptr head = 0;  // Bytes used in the current region
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "SceneModel.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Structure-of-arrays scratch for cullModels, reused between frames
+static std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+static std::vector<unsigned char> sphereVisible;
+
+size_t cullModels(const Frustum& frustum, SceneModel* models, size_t modelCount)
+{
+    sphereX.resize(modelCount);
+    sphereY.resize(modelCount);
+    sphereZ.resize(modelCount);
+    sphereRadius.resize(modelCount);
+    sphereVisible.resize(modelCount);
+    for (size_t i = 0; i < modelCount; i++)
+    {
+        BoundingSphere sphere = transformSphere(models[i].mesh->bounds.sphere, models[i].placement.m);
+        sphereX[i] = sphere.center.x;
+        sphereY[i] = sphere.center.y;
+        sphereZ[i] = sphere.center.z;
+        sphereRadius[i] = sphere.radius;
+    }
+
+    size_t visibleCount = cullSpheres(frustum, sphereX.data(), sphereY.data(), sphereZ.data(), sphereRadius.data(),
+        modelCount, sphereVisible.data());
+    for (size_t i = 0; i < modelCount; i++)
+        models[i].visible = sphereVisible[i] != 0;
+    return visibleCount;
+}
+
+void selectModelLod(SceneModel& model, const Vector3& eye, float projectionScale)
+{
+    const Mesh& mesh = *model.mesh;
+    float scale = maxAxisScale(model.placement.m);
+    BoundingSphere world = transformSphere(mesh.bounds.sphere, model.placement.m);
+    Vector3 toSphere = world.center - eye;
+    float distance = sqrtf(toSphere.x * toSphere.x + toSphere.y * toSphere.y + toSphere.z * toSphere.z) - world.radius;
+
+    model.lod = selectLod(mesh.lodErrors, mesh.lodCount, scale, distance, projectionScale, model.lod);
+}
+
+bool writeModelNodes(RingBuffer& ring, SceneModel& model)
+{
+    const Mesh& mesh = *model.mesh;
+    RingAllocation allocation = ring.allocate(mesh.nodes.size() * sizeof(InstanceData), sizeof(InstanceData));
+    if (!allocation.data)
+        return false;
+    model.firstNodeInstance = (GLuint)(allocation.offset / sizeof(InstanceData));
+
+    // position = offset + scale * attribute, before the node's own transform.
+    // Normals are packed on their own and need no correction.
+    Mat4 dequantize = Mat4::scale(
+        Mat4::translate(Mat4::identity(), mesh.positionOffset[0], mesh.positionOffset[1], mesh.positionOffset[2]),
+        mesh.positionScale[0], mesh.positionScale[1], mesh.positionScale[2]);
+
+    InstanceData* out = (InstanceData*)allocation.data;
+    for (size_t i = 0; i < mesh.nodes.size(); i++)
+    {
+        Mat4 world = model.placement * mesh.nodes[i].world;
+        Mat4 position = world * dequantize;
+        Mat4 normal = Mat4::normalMatrix(world);
+        memcpy(out[i].model, position.m, sizeof(out[i].model));
+        memcpy(out[i].normal, normal.m, sizeof(out[i].normal));
+        memcpy(out[i].color, mesh.texCoordTransform, sizeof(out[i].color));
+    }
+    return true;
+}
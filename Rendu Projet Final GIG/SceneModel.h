@@ -0,0 +1,39 @@
+#ifndef SCENEMODEL_H
+#define SCENEMODEL_H
+
+#include <glad/glad.h>
+#include "Frustum.h"
+#include "Instancing.h"
+#include "Mat4.h"
+#include "ModelLoader.h"
+#include "RingBuffer.h"
+
+// A loaded model placed in the scene. Every node of its mesh is one entry of
+// the instance data streamed each frame, starting at firstNodeInstance; the
+// baseInstance of each command from appendDrawCommands selects its submesh's
+// node, so a whole model with many nodes is still one multi-draw.
+struct SceneModel {
+    const Mesh* mesh = NULL;            // Not owned; its VAO has the ring attached (attachInstanceBuffer)
+    Mat4 placement = Mat4::identity();  // Model space to world space
+    GLuint texture = 0;                 // Drawn instead of mesh->textureID when non-zero, e.g. a registry texture
+    GLuint firstNodeInstance = 0;       // This frame's, set by writeModelNodes
+    unsigned int lod = 0;               // Detail level picked by selectModelLod, kept for its hysteresis
+    bool visible = true;                // This frame's, set by cullModels
+};
+
+// Set each model's visible flag from its placed bounding sphere against the
+// frustum. Returns the number of visible models.
+size_t cullModels(const Frustum& frustum, SceneModel* models, size_t modelCount);
+
+// Pick model.lod from mesh.lodErrors, the placement's scale and the distance
+// from eye to the model's bounding sphere. projectionScale comes from
+// lodProjectionScale().
+void selectModelLod(SceneModel& model, const Vector3& eye, float projectionScale);
+
+// Stream one InstanceData per node of model.mesh into this frame's region of
+// the ring: the node's world matrix under the placement, with the mesh's
+// position dequantization folded in, its normal matrix, and the UV transform
+// in place of the color (see texture_vertex_shader.glsl)
+bool writeModelNodes(RingBuffer& ring, SceneModel& model);
+
+#endif
@@ -0,0 +1,102 @@
+#include "ShaderProgram.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Load shader source code from file
+std::string loadShaderSource(const char* filename)
+{
+    std::ifstream file(filename);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Compile shader
+GLuint compileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cerr << "Shader compilation failed: " << log << std::endl;
+    }
+    return shader;
+}
+
+// Reflect all active uniforms into the program's flat table
+static void reflectUniforms(ShaderProgram& program)
+{
+    GLint count = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+
+    for (GLint i = 0; i < count; i++)
+    {
+        char name[256];
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(program.id, i, sizeof(name), NULL, &size, &type, name);
+
+        // Members of uniform blocks have no location
+        GLint location = glGetUniformLocation(program.id, name);
+        if (location < 0)
+            continue;
+
+        UniformInfo info;
+        info.name = name;
+        size_t bracket = info.name.find('[');
+        if (bracket != std::string::npos)
+            info.name.erase(bracket);
+        info.location = location;
+        info.type = type;
+        info.count = size;
+        program.uniforms.push_back(info);
+    }
+}
+
+// Create shader program
+ShaderProgram createShaderProgram(const char* vertexPath, const char* fragmentPath)
+{
+    std::string vertexCode = loadShaderSource(vertexPath);
+    std::string fragmentCode = loadShaderSource(fragmentPath);
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str());
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
+
+    ShaderProgram program;
+    program.id = glCreateProgram();
+    glAttachShader(program.id, vertexShader);
+    glAttachShader(program.id, fragmentShader);
+    glLinkProgram(program.id);
+
+    GLint success;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program.id, sizeof(log), NULL, log);
+        std::cerr << "Shader link failed (" << vertexPath << ", " << fragmentPath << "): " << log << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    reflectUniforms(program);
+    return program;
+}
+
+int ShaderProgram::uniform(const char* name) const
+{
+    for (size_t i = 0; i < uniforms.size(); i++)
+    {
+        if (uniforms[i].name == name)
+            return (int)i;
+    }
+    return -1;
+}
@@ -0,0 +1,29 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// Active uniform, reflected once when the program is linked
+struct UniformInfo {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint count;
+};
+
+// Linked program with a flat table of its active uniforms. Per-frame values go
+// through the FrameData block, so nothing is uploaded per program here.
+struct ShaderProgram {
+    GLuint id = 0;
+    std::vector<UniformInfo> uniforms;
+
+    int uniform(const char* name) const;  // Index in the table, -1 if not active
+};
+
+std::string loadShaderSource(const char* filename);
+GLuint compileShader(GLenum type, const char* source);
+ShaderProgram createShaderProgram(const char* vertexPath, const char* fragmentPath);
+
+#endif
@@ -0,0 +1,44 @@
+#include "SimdPackets.h"
+
+#if defined(SIMD_X86)
+
+// Eight vectors per iteration; the remainder goes through the scalar kernels
+
+SIMD_TARGET_AVX2 static void transformPointsAvx2(const Mat4& m, Vec3Soa in, Vec3Soa out, size_t count)
+{
+    Affine8 affine = splatAffine8(m);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        storeVec3x8(out, i, transformPoint(affine, loadVec3x8(in, i)));
+    SIMD_KERNELS_SCALAR.transformPoints(m, offsetSoa(in, i), offsetSoa(out, i), count - i);
+}
+
+SIMD_TARGET_AVX2 static void dotAvx2(Vec3Soa a, Vec3Soa b, float* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, dot(loadVec3x8(a, i), loadVec3x8(b, i)));
+    SIMD_KERNELS_SCALAR.dot(offsetSoa(a, i), offsetSoa(b, i), out + i, count - i);
+}
+
+SIMD_TARGET_AVX2 static void crossAvx2(Vec3Soa a, Vec3Soa b, Vec3Soa out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        storeVec3x8(out, i, cross(loadVec3x8(a, i), loadVec3x8(b, i)));
+    SIMD_KERNELS_SCALAR.cross(offsetSoa(a, i), offsetSoa(b, i), offsetSoa(out, i), count - i);
+}
+
+SIMD_TARGET_AVX2 static void normalizeAvx2(Vec3Soa v, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        storeVec3x8(v, i, normalize(loadVec3x8(v, i)));
+    SIMD_KERNELS_SCALAR.normalize(offsetSoa(v, i), count - i);
+}
+
+const SimdKernels SIMD_KERNELS_AVX2 = {
+    SIMD_AVX2, "AVX2", transformPointsAvx2, dotAvx2, crossAvx2, normalizeAvx2
+};
+
+#endif
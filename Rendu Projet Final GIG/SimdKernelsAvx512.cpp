@@ -0,0 +1,85 @@
+#include "SimdPackets.h"
+
+#if defined(SIMD_X86)
+
+// Sixteen vectors per iteration. The last partial packet uses masked loads and
+// stores, so there is no scalar remainder.
+
+SIMD_TARGET_AVX512 static __mmask16 tailMask(size_t remaining)
+{
+    return remaining >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << remaining) - 1);
+}
+
+SIMD_TARGET_AVX512 static void transformPointsAvx512(const Mat4& m, Vec3Soa in, Vec3Soa out, size_t count)
+{
+    __m512 a[12];
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 3; row++)
+            a[col * 3 + row] = _mm512_set1_ps(m.m[col * 4 + row]);
+    }
+
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 mask = tailMask(count - i);
+        __m512 x = _mm512_maskz_loadu_ps(mask, in.x + i);
+        __m512 y = _mm512_maskz_loadu_ps(mask, in.y + i);
+        __m512 z = _mm512_maskz_loadu_ps(mask, in.z + i);
+        _mm512_mask_storeu_ps(out.x + i, mask, _mm512_fmadd_ps(a[0], x, _mm512_fmadd_ps(a[3], y, _mm512_fmadd_ps(a[6], z, a[9]))));
+        _mm512_mask_storeu_ps(out.y + i, mask, _mm512_fmadd_ps(a[1], x, _mm512_fmadd_ps(a[4], y, _mm512_fmadd_ps(a[7], z, a[10]))));
+        _mm512_mask_storeu_ps(out.z + i, mask, _mm512_fmadd_ps(a[2], x, _mm512_fmadd_ps(a[5], y, _mm512_fmadd_ps(a[8], z, a[11]))));
+    }
+}
+
+SIMD_TARGET_AVX512 static void dotAvx512(Vec3Soa a, Vec3Soa b, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 mask = tailMask(count - i);
+        __m512 d = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, a.x + i), _mm512_maskz_loadu_ps(mask, b.x + i));
+        d = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a.y + i), _mm512_maskz_loadu_ps(mask, b.y + i), d);
+        d = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a.z + i), _mm512_maskz_loadu_ps(mask, b.z + i), d);
+        _mm512_mask_storeu_ps(out + i, mask, d);
+    }
+}
+
+SIMD_TARGET_AVX512 static void crossAvx512(Vec3Soa a, Vec3Soa b, Vec3Soa out, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 mask = tailMask(count - i);
+        __m512 ax = _mm512_maskz_loadu_ps(mask, a.x + i), ay = _mm512_maskz_loadu_ps(mask, a.y + i), az = _mm512_maskz_loadu_ps(mask, a.z + i);
+        __m512 bx = _mm512_maskz_loadu_ps(mask, b.x + i), by = _mm512_maskz_loadu_ps(mask, b.y + i), bz = _mm512_maskz_loadu_ps(mask, b.z + i);
+        _mm512_mask_storeu_ps(out.x + i, mask, _mm512_fmsub_ps(ay, bz, _mm512_mul_ps(az, by)));
+        _mm512_mask_storeu_ps(out.y + i, mask, _mm512_fmsub_ps(az, bx, _mm512_mul_ps(ax, bz)));
+        _mm512_mask_storeu_ps(out.z + i, mask, _mm512_fmsub_ps(ax, by, _mm512_mul_ps(ay, bx)));
+    }
+}
+
+SIMD_TARGET_AVX512 static void normalizeAvx512(Vec3Soa v, size_t count)
+{
+    for (size_t i = 0; i < count; i += 16)
+    {
+        __mmask16 mask = tailMask(count - i);
+        __m512 x = _mm512_maskz_loadu_ps(mask, v.x + i);
+        __m512 y = _mm512_maskz_loadu_ps(mask, v.y + i);
+        __m512 z = _mm512_maskz_loadu_ps(mask, v.z + i);
+        __m512 lengthSq = _mm512_fmadd_ps(z, z, _mm512_fmadd_ps(y, y, _mm512_mul_ps(x, x)));
+
+        // rsqrt14 refined by one Newton-Raphson step; zero lengths give zero
+        __mmask16 nonZero = _mm512_cmp_ps_mask(lengthSq, _mm512_setzero_ps(), _CMP_GT_OQ);
+        __m512 estimate = _mm512_maskz_rsqrt14_ps(nonZero, lengthSq);
+        __m512 halfLengthSq = _mm512_mul_ps(lengthSq, _mm512_set1_ps(0.5f));
+        estimate = _mm512_mul_ps(estimate, _mm512_fnmadd_ps(halfLengthSq, _mm512_mul_ps(estimate, estimate), _mm512_set1_ps(1.5f)));
+
+        _mm512_mask_storeu_ps(v.x + i, mask, _mm512_mul_ps(x, estimate));
+        _mm512_mask_storeu_ps(v.y + i, mask, _mm512_mul_ps(y, estimate));
+        _mm512_mask_storeu_ps(v.z + i, mask, _mm512_mul_ps(z, estimate));
+    }
+}
+
+const SimdKernels SIMD_KERNELS_AVX512 = {
+    SIMD_AVX512, "AVX-512", transformPointsAvx512, dotAvx512, crossAvx512, normalizeAvx512
+};
+
+#endif
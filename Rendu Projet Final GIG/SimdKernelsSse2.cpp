@@ -0,0 +1,44 @@
+#include "SimdPackets.h"
+
+#if defined(SIMD_X86)
+
+// Four vectors per iteration; the remainder goes through the scalar kernels
+
+static void transformPointsSse2(const Mat4& m, Vec3Soa in, Vec3Soa out, size_t count)
+{
+    Affine4 affine = splatAffine4(m);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        storeVec3x4(out, i, transformPoint(affine, loadVec3x4(in, i)));
+    SIMD_KERNELS_SCALAR.transformPoints(m, offsetSoa(in, i), offsetSoa(out, i), count - i);
+}
+
+static void dotSse2(Vec3Soa a, Vec3Soa b, float* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, dot(loadVec3x4(a, i), loadVec3x4(b, i)));
+    SIMD_KERNELS_SCALAR.dot(offsetSoa(a, i), offsetSoa(b, i), out + i, count - i);
+}
+
+static void crossSse2(Vec3Soa a, Vec3Soa b, Vec3Soa out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        storeVec3x4(out, i, cross(loadVec3x4(a, i), loadVec3x4(b, i)));
+    SIMD_KERNELS_SCALAR.cross(offsetSoa(a, i), offsetSoa(b, i), offsetSoa(out, i), count - i);
+}
+
+static void normalizeSse2(Vec3Soa v, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        storeVec3x4(v, i, normalize(loadVec3x4(v, i)));
+    SIMD_KERNELS_SCALAR.normalize(offsetSoa(v, i), count - i);
+}
+
+const SimdKernels SIMD_KERNELS_SSE2 = {
+    SIMD_SSE2, "SSE2", transformPointsSse2, dotSse2, crossSse2, normalizeSse2
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "SimdMath.h"
+#include <cmath>
+
+#if defined(SIMD_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Points converted per block by the AoS transformPoints
+const size_t SIMD_AOS_BLOCK = 256;
+
+static void transformPointsScalar(const Mat4& m, Vec3Soa in, Vec3Soa out, size_t count)
+{
+    const float* a = m.m;
+    for (size_t i = 0; i < count; i++)
+    {
+        float x = in.x[i], y = in.y[i], z = in.z[i];
+        out.x[i] = a[0] * x + a[4] * y + a[8] * z + a[12];
+        out.y[i] = a[1] * x + a[5] * y + a[9] * z + a[13];
+        out.z[i] = a[2] * x + a[6] * y + a[10] * z + a[14];
+    }
+}
+
+static void dotScalar(Vec3Soa a, Vec3Soa b, float* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+}
+
+static void crossScalar(Vec3Soa a, Vec3Soa b, Vec3Soa out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float x = a.y[i] * b.z[i] - a.z[i] * b.y[i];
+        float y = a.z[i] * b.x[i] - a.x[i] * b.z[i];
+        float z = a.x[i] * b.y[i] - a.y[i] * b.x[i];
+        out.x[i] = x;
+        out.y[i] = y;
+        out.z[i] = z;
+    }
+}
+
+static void normalizeScalar(Vec3Soa v, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float lengthSq = v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i];
+        float inv = lengthSq > 0.0f ? 1.0f / sqrtf(lengthSq) : 0.0f;
+        v.x[i] *= inv;
+        v.y[i] *= inv;
+        v.z[i] *= inv;
+    }
+}
+
+const SimdKernels SIMD_KERNELS_SCALAR = {
+    SIMD_SCALAR, "scalar", transformPointsScalar, dotScalar, crossScalar, normalizeScalar
+};
+
+SimdLevel detectSimdLevel()
+{
+#if defined(SIMD_X86)
+    unsigned int regs[4] = {};  // eax, ebx, ecx, edx
+#if defined(_MSC_VER)
+    __cpuid((int*)regs, 0);
+#else
+    __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    unsigned int maxLeaf = regs[0];
+
+#if defined(_MSC_VER)
+    __cpuid((int*)regs, 1);
+#else
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    bool sse2 = (regs[3] & (1u << 26)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    if (!sse2)
+        return SIMD_SCALAR;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return SIMD_SSE2;
+
+    // The OS must save the YMM (and for AVX-512 the opmask and ZMM) registers
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)xcr0High << 32) | xcr0Low;
+#endif
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+#if defined(_MSC_VER)
+    __cpuidex((int*)regs, 7, 0);
+#else
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    bool avx2 = (regs[1] & (1u << 5)) != 0;
+    bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+    if (avx512f && avx2 && fma && zmmState)
+        return SIMD_AVX512;
+    if (avx2 && fma && ymmState)
+        return SIMD_AVX2;
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+const SimdKernels* simdKernelsFor(SimdLevel level)
+{
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported)
+        return NULL;
+
+    switch (level)
+    {
+#if defined(SIMD_X86)
+    case SIMD_SSE2: return &SIMD_KERNELS_SSE2;
+    case SIMD_AVX2: return &SIMD_KERNELS_AVX2;
+    case SIMD_AVX512: return &SIMD_KERNELS_AVX512;
+#endif
+    default: return &SIMD_KERNELS_SCALAR;
+    }
+}
+
+const SimdKernels& simdKernels()
+{
+    static const SimdKernels* kernels = simdKernelsFor(detectSimdLevel());
+    return *kernels;
+}
+
+void transformPoints(const Mat4& m, const Vector3* points, Vector3* out, size_t count)
+{
+    const SimdKernels& kernels = simdKernels();
+    float x[SIMD_AOS_BLOCK], y[SIMD_AOS_BLOCK], z[SIMD_AOS_BLOCK];
+    Vec3Soa block = { x, y, z };
+
+    for (size_t start = 0; start < count; start += SIMD_AOS_BLOCK)
+    {
+        size_t n = count - start < SIMD_AOS_BLOCK ? count - start : SIMD_AOS_BLOCK;
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] = points[start + i].x;
+            y[i] = points[start + i].y;
+            z[i] = points[start + i].z;
+        }
+        kernels.transformPoints(m, block, block, n);
+        for (size_t i = 0; i < n; i++)
+            out[start + i] = Vector3(x[i], y[i], z[i]);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SIMDMATH_H
+#define SIMDMATH_H
+
+#include <cstddef>
+#include "Mat4.h"
+#include "Vector3.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#endif
+
+// Instruction sets the batch kernels are built for, in increasing width
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2,    // AVX2 + FMA
+    SIMD_AVX512   // AVX-512F
+};
+
+// Structure-of-arrays view of count 3D vectors
+struct Vec3Soa {
+    float* x;
+    float* y;
+    float* z;
+};
+
+// The same arrays starting at element i
+inline Vec3Soa offsetSoa(const Vec3Soa& v, size_t i)
+{
+    Vec3Soa r = { v.x + i, v.y + i, v.z + i };
+    return r;
+}
+
+// One implementation of every batch operation. Inputs and outputs may alias.
+struct SimdKernels {
+    SimdLevel level;
+    const char* name;
+    void (*transformPoints)(const Mat4& m, Vec3Soa in, Vec3Soa out, size_t count);  // w = 1, affine part of m
+    void (*dot)(Vec3Soa a, Vec3Soa b, float* out, size_t count);
+    void (*cross)(Vec3Soa a, Vec3Soa b, Vec3Soa out, size_t count);
+    void (*normalize)(Vec3Soa v, size_t count);  // Fast reciprocal square root, zero vectors stay zero
+};
+
+// Kernel tables, one per translation unit. Only the ones the build and the
+// CPU support may be called; use simdKernels() or simdKernelsFor()
+extern const SimdKernels SIMD_KERNELS_SCALAR;
+extern const SimdKernels SIMD_KERNELS_SSE2;
+extern const SimdKernels SIMD_KERNELS_AVX2;
+extern const SimdKernels SIMD_KERNELS_AVX512;
+
+// Widest level supported by both the CPU (CPUID) and the OS (XSAVE state)
+SimdLevel detectSimdLevel();
+
+// Kernels for the detected level, selected once on first use
+const SimdKernels& simdKernels();
+
+// Kernels for a given level, NULL when this CPU cannot run them
+const SimdKernels* simdKernelsFor(SimdLevel level);
+
+// Transform an array of Vector3 (AoS) by going through SoA blocks
+void transformPoints(const Mat4& m, const Vector3* points, Vector3* out, size_t count);
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef SIMDPACKETS_H
+#define SIMDPACKETS_H
+
+#include "SimdMath.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+
+// Functions using wider instructions than the build default are compiled for
+// their own target (GCC/Clang). MSVC accepts the intrinsics anywhere; the
+// kernel files must not get a wider /arch, or the inline helpers they share
+// with the other files (offsetSoa, Mat4) could be linked in their AVX copy.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+// Four 3D vectors in SoA form (SSE2)
+struct Vec3x4 {
+    __m128 x, y, z;
+};
+
+// Rows 0-2 of an affine Mat4, each entry broadcast to all lanes
+struct Affine4 {
+    __m128 m[12];
+};
+
+inline Vec3x4 loadVec3x4(const Vec3Soa& v, size_t i)
+{
+    Vec3x4 r = { _mm_loadu_ps(v.x + i), _mm_loadu_ps(v.y + i), _mm_loadu_ps(v.z + i) };
+    return r;
+}
+
+inline void storeVec3x4(const Vec3Soa& v, size_t i, const Vec3x4& a)
+{
+    _mm_storeu_ps(v.x + i, a.x);
+    _mm_storeu_ps(v.y + i, a.y);
+    _mm_storeu_ps(v.z + i, a.z);
+}
+
+inline Vec3x4 operator+(const Vec3x4& a, const Vec3x4& b)
+{
+    Vec3x4 r = { _mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z) };
+    return r;
+}
+
+inline Vec3x4 operator-(const Vec3x4& a, const Vec3x4& b)
+{
+    Vec3x4 r = { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+    return r;
+}
+
+inline Vec3x4 operator*(const Vec3x4& a, __m128 s)
+{
+    Vec3x4 r = { _mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s) };
+    return r;
+}
+
+inline __m128 dot(const Vec3x4& a, const Vec3x4& b)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+inline Vec3x4 cross(const Vec3x4& a, const Vec3x4& b)
+{
+    Vec3x4 r = {
+        _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+        _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+        _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x))
+    };
+    return r;
+}
+
+// rsqrt estimate refined by one Newton-Raphson step (~22 bits); zero stays zero
+inline Vec3x4 normalize(const Vec3x4& a)
+{
+    __m128 lengthSq = dot(a, a);
+    __m128 estimate = _mm_rsqrt_ps(lengthSq);
+    __m128 halfLengthSq = _mm_mul_ps(lengthSq, _mm_set1_ps(0.5f));
+    estimate = _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfLengthSq, _mm_mul_ps(estimate, estimate))));
+    estimate = _mm_and_ps(estimate, _mm_cmpgt_ps(lengthSq, _mm_setzero_ps()));
+    return a * estimate;
+}
+
+inline Affine4 splatAffine4(const Mat4& mat)
+{
+    Affine4 r;
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 3; row++)
+            r.m[col * 3 + row] = _mm_set1_ps(mat.m[col * 4 + row]);
+    }
+    return r;
+}
+
+inline Vec3x4 transformPoint(const Affine4& m, const Vec3x4& p)
+{
+    Vec3x4 r;
+    r.x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[0], p.x), _mm_mul_ps(m.m[3], p.y)), _mm_add_ps(_mm_mul_ps(m.m[6], p.z), m.m[9]));
+    r.y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[1], p.x), _mm_mul_ps(m.m[4], p.y)), _mm_add_ps(_mm_mul_ps(m.m[7], p.z), m.m[10]));
+    r.z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[2], p.x), _mm_mul_ps(m.m[5], p.y)), _mm_add_ps(_mm_mul_ps(m.m[8], p.z), m.m[11]));
+    return r;
+}
+
+// Eight 3D vectors in SoA form (AVX2 + FMA)
+struct Vec3x8 {
+    __m256 x, y, z;
+};
+
+struct Affine8 {
+    __m256 m[12];
+};
+
+SIMD_TARGET_AVX2 inline Vec3x8 loadVec3x8(const Vec3Soa& v, size_t i)
+{
+    Vec3x8 r = { _mm256_loadu_ps(v.x + i), _mm256_loadu_ps(v.y + i), _mm256_loadu_ps(v.z + i) };
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline void storeVec3x8(const Vec3Soa& v, size_t i, const Vec3x8& a)
+{
+    _mm256_storeu_ps(v.x + i, a.x);
+    _mm256_storeu_ps(v.y + i, a.y);
+    _mm256_storeu_ps(v.z + i, a.z);
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 operator+(const Vec3x8& a, const Vec3x8& b)
+{
+    Vec3x8 r = { _mm256_add_ps(a.x, b.x), _mm256_add_ps(a.y, b.y), _mm256_add_ps(a.z, b.z) };
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 operator-(const Vec3x8& a, const Vec3x8& b)
+{
+    Vec3x8 r = { _mm256_sub_ps(a.x, b.x), _mm256_sub_ps(a.y, b.y), _mm256_sub_ps(a.z, b.z) };
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 operator*(const Vec3x8& a, __m256 s)
+{
+    Vec3x8 r = { _mm256_mul_ps(a.x, s), _mm256_mul_ps(a.y, s), _mm256_mul_ps(a.z, s) };
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline __m256 dot(const Vec3x8& a, const Vec3x8& b)
+{
+    return _mm256_fmadd_ps(a.z, b.z, _mm256_fmadd_ps(a.y, b.y, _mm256_mul_ps(a.x, b.x)));
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 cross(const Vec3x8& a, const Vec3x8& b)
+{
+    Vec3x8 r = {
+        _mm256_fmsub_ps(a.y, b.z, _mm256_mul_ps(a.z, b.y)),
+        _mm256_fmsub_ps(a.z, b.x, _mm256_mul_ps(a.x, b.z)),
+        _mm256_fmsub_ps(a.x, b.y, _mm256_mul_ps(a.y, b.x))
+    };
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 normalize(const Vec3x8& a)
+{
+    __m256 lengthSq = dot(a, a);
+    __m256 estimate = _mm256_rsqrt_ps(lengthSq);
+    __m256 halfLengthSq = _mm256_mul_ps(lengthSq, _mm256_set1_ps(0.5f));
+    estimate = _mm256_mul_ps(estimate, _mm256_fnmadd_ps(halfLengthSq, _mm256_mul_ps(estimate, estimate), _mm256_set1_ps(1.5f)));
+    estimate = _mm256_and_ps(estimate, _mm256_cmp_ps(lengthSq, _mm256_setzero_ps(), _CMP_GT_OQ));
+    return a * estimate;
+}
+
+SIMD_TARGET_AVX2 inline Affine8 splatAffine8(const Mat4& mat)
+{
+    Affine8 r;
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 3; row++)
+            r.m[col * 3 + row] = _mm256_set1_ps(mat.m[col * 4 + row]);
+    }
+    return r;
+}
+
+SIMD_TARGET_AVX2 inline Vec3x8 transformPoint(const Affine8& m, const Vec3x8& p)
+{
+    Vec3x8 r;
+    r.x = _mm256_fmadd_ps(m.m[0], p.x, _mm256_fmadd_ps(m.m[3], p.y, _mm256_fmadd_ps(m.m[6], p.z, m.m[9])));
+    r.y = _mm256_fmadd_ps(m.m[1], p.x, _mm256_fmadd_ps(m.m[4], p.y, _mm256_fmadd_ps(m.m[7], p.z, m.m[10])));
+    r.z = _mm256_fmadd_ps(m.m[2], p.x, _mm256_fmadd_ps(m.m[5], p.y, _mm256_fmadd_ps(m.m[8], p.z, m.m[11])));
+    return r;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+
+ThreadPool::~ThreadPool()
+{
+    stop();
+}
+
+unsigned int ThreadPool::defaultWorkerCount()
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return (count > 0) ? count : 1;
+}
+
+void ThreadPool::start(unsigned int workerCount)
+{
+    if (workerCount == 0)
+        workerCount = defaultWorkerCount();
+    for (unsigned int i = 0; i < workerCount; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, (unsigned int)workers.size()));
+}
+
+void ThreadPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+    stopping = false;
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && busy == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned int worker)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping)
+            return;
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        busy++;
+        lock.unlock();
+
+        task(worker);
+
+        lock.lock();
+        busy--;
+        idle.notify_all();
+    }
+}
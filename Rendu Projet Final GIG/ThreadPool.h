@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued tasks in submission order.
+// A task gets the index of the worker running it, so callers can keep one
+// instance of a non-thread-safe object (an Assimp importer) per worker.
+class ThreadPool {
+public:
+    typedef std::function<void(unsigned int worker)> Task;
+
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void start(unsigned int workerCount);  // 0 picks defaultWorkerCount()
+    void stop();  // Running tasks finish, queued ones are dropped
+    void submit(Task task);
+    void wait();  // Until the queue is empty and every worker is idle
+
+    unsigned int size() const { return (unsigned int)workers.size(); }
+
+    static unsigned int defaultWorkerCount();  // Hardware threads, at least 1
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;  // A task was queued, or stopping
+    std::condition_variable idle;  // A task finished
+    std::deque<Task> tasks;
+    unsigned int busy = 0;
+    bool stopping = false;
+
+    void workerLoop(unsigned int worker);
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cstring>
+
+int TransformHierarchy::add(int parent, const Vector3& position, const Quat& rotation, const Vector3& scaling)
+{
+    int slot = (int)parents.size();
+    int parentSlot = parent == TRANSFORM_ROOT ? TRANSFORM_ROOT : slotOf[parent];
+    int node = (int)slotOf.size();
+
+    parents.push_back(parentSlot);
+    depths.push_back(parentSlot == TRANSFORM_ROOT ? 0 : depths[parentSlot] + 1);
+    nodeOf.push_back(node);
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scaling);
+    worlds.push_back(Mat4::identity());
+    dirtyFlags.push_back(0);
+    changedFlags.push_back(0);
+    slotOf.push_back(slot);
+
+    layoutChanged = true;
+    markDirty(slot);
+    return node;
+}
+
+void TransformHierarchy::markDirty(int slot)
+{
+    dirtyFlags[slot] = 1;
+    if ((size_t)slot < firstDirty)
+        firstDirty = slot;
+}
+
+void TransformHierarchy::setPosition(int node, const Vector3& position)
+{
+    int slot = slotOf[node];
+    positions[slot] = position;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setRotation(int node, const Quat& rotation)
+{
+    int slot = slotOf[node];
+    rotations[slot] = rotation;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setScale(int node, const Vector3& scaling)
+{
+    int slot = slotOf[node];
+    scales[slot] = scaling;
+    markDirty(slot);
+}
+
+// Stable sort of every per-slot array by depth, then rebuild the level ranges
+void TransformHierarchy::sortByDepth()
+{
+    size_t count = parents.size();
+    std::vector<int> order(count);
+    for (size_t i = 0; i < count; i++)
+        order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return depths[a] < depths[b]; });
+
+    std::vector<int> newSlot(count);
+    for (size_t i = 0; i < count; i++)
+        newSlot[order[i]] = (int)i;
+
+    std::vector<int> oldParents = parents, oldDepths = depths, oldNodes = nodeOf;
+    std::vector<Vector3> oldPositions = positions, oldScales = scales;
+    std::vector<Quat> oldRotations = rotations;
+    std::vector<Mat4> oldWorlds = worlds;
+    std::vector<unsigned char> oldDirty = dirtyFlags;
+    for (size_t i = 0; i < count; i++)
+    {
+        int from = order[i];
+        parents[i] = oldParents[from] == TRANSFORM_ROOT ? TRANSFORM_ROOT : newSlot[oldParents[from]];
+        depths[i] = oldDepths[from];
+        nodeOf[i] = oldNodes[from];
+        positions[i] = oldPositions[from];
+        rotations[i] = oldRotations[from];
+        scales[i] = oldScales[from];
+        worlds[i] = oldWorlds[from];
+        dirtyFlags[i] = oldDirty[from];
+        slotOf[nodeOf[i]] = (int)i;
+    }
+
+    levelStart.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        while ((int)levelStart.size() <= depths[i])
+            levelStart.push_back(i);
+    }
+    levelStart.push_back(count);
+
+    // Slots moved, so no range is known to be clean any more
+    firstDirty = 0;
+    updateBegin = 0;
+}
+
+void TransformHierarchy::beginUpdate()
+{
+    if (layoutChanged)
+    {
+        sortByDepth();
+        layoutChanged = false;
+    }
+
+    // Only slots from the previous update's start can still be flagged
+    size_t count = changedFlags.size();
+    if (updateBegin < count)
+        memset(&changedFlags[updateBegin], 0, count - updateBegin);
+
+    updateBegin = firstDirty;
+    firstDirty = count;
+}
+
+unsigned int TransformHierarchy::updateRange(size_t begin, size_t end)
+{
+    unsigned int updated = 0;
+    for (size_t i = std::max(begin, updateBegin); i < end; i++)
+    {
+        int parent = parents[i];
+        if (!dirtyFlags[i] && (parent == TRANSFORM_ROOT || !changedFlags[parent]))
+            continue;
+
+        Mat4 local = Mat4::trs(positions[i], rotations[i], scales[i]);
+        worlds[i] = parent == TRANSFORM_ROOT ? local : worlds[parent] * local;
+        dirtyFlags[i] = 0;
+        changedFlags[i] = 1;
+        updated++;
+    }
+    return updated;
+}
+
+void TransformHierarchy::updateWorld()
+{
+    beginUpdate();
+    updatedNodes = updateRange(updateBegin, parents.size());
+}
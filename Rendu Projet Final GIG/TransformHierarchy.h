@@ -0,0 +1,67 @@
+#ifndef TRANSFORMHIERARCHY_H
+#define TRANSFORMHIERARCHY_H
+
+#include <cstddef>
+#include <vector>
+#include "Mat4.h"
+#include "Quat.h"
+#include "Vector3.h"
+
+const int TRANSFORM_ROOT = -1;  // Parent of nodes without one
+
+// Scene transforms stored as flat arrays sorted by depth: every node comes
+// after its parent, and all nodes of one depth are contiguous. Handles given
+// out by add() stay valid when the arrays are re-sorted.
+//
+// Setting a local TRS only raises a dirty bit. updateWorld() walks the arrays
+// once from the first dirty slot, recomputing a world matrix only when the
+// node or one of its ancestors changed, so static parts of the scene cost a
+// flag test. Slots of one depth level do not depend on each other: any split
+// of [levelBegin(d), levelEnd(d)) into chunks can be passed to updateRange()
+// on separate threads once the levels above are done.
+struct TransformHierarchy {
+    unsigned int updatedNodes = 0;  // World matrices recomputed by the last updateWorld()
+
+    int add(int parent, const Vector3& position, const Quat& rotation, const Vector3& scaling);
+
+    void setPosition(int node, const Vector3& position);
+    void setRotation(int node, const Quat& rotation);
+    void setScale(int node, const Vector3& scaling);
+
+    const Mat4& world(int node) const { return worlds[slotOf[node]]; }
+    bool changed(int node) const { return changedFlags[slotOf[node]] != 0; }  // World matrix recomputed by the last update
+
+    void updateWorld();
+
+    // Chunked update, see above. beginUpdate() must come first and no local
+    // TRS may change until every range is done; updateRange() returns the
+    // number of world matrices it recomputed.
+    void beginUpdate();
+    size_t levelCount() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+    size_t levelBegin(size_t level) const { return levelStart[level]; }
+    size_t levelEnd(size_t level) const { return levelStart[level + 1]; }
+    unsigned int updateRange(size_t begin, size_t end);
+
+private:
+    // Per slot, in depth order
+    std::vector<int> parents;  // Parent slot or TRANSFORM_ROOT
+    std::vector<int> depths;
+    std::vector<int> nodeOf;   // Handle stored in each slot
+    std::vector<Vector3> positions;
+    std::vector<Quat> rotations;
+    std::vector<Vector3> scales;
+    std::vector<Mat4> worlds;
+    std::vector<unsigned char> dirtyFlags;    // Local TRS changed since the last update
+    std::vector<unsigned char> changedFlags;  // World matrix recomputed by the last update
+
+    std::vector<int> slotOf;   // Per handle
+    std::vector<size_t> levelStart;
+    size_t firstDirty = 0;     // No slot before this one is dirty
+    size_t updateBegin = 0;    // firstDirty when the current update began
+    bool layoutChanged = false;
+
+    void markDirty(int slot);
+    void sortByDepth();
+};
+
+#endif
@@ -1,22 +1,31 @@
 #version 460 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 3) in mat4 instanceModel;  // Per instance, locations 3-6
+layout (location = 7) in mat3 instanceNormal;  // Per instance, locations 7-9
+layout (location = 10) in vec4 instanceColor;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 ViewDir;
+flat out vec3 ObjectColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 cameraPos;
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightDir;
+    vec4 lightColor;
+};
 
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec4 worldPos = instanceModel * vec4(aPos, 1.0);
     FragPos = worldPos.xyz;
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    ViewDir = normalize(cameraPos - FragPos);
+    Normal = instanceNormal * aNormal;
+    ViewDir = normalize(cameraPos.xyz - FragPos);
+    ObjectColor = instanceColor.rgb;
 
     gl_Position = projection * view * worldPos;
 }
@@ -2,27 +2,33 @@
 
 in vec3 FragPos;
 in vec3 Normal;
+flat in vec3 ObjectColor;
 
 out vec4 FragColor;
 
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 objectColor;
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightDir;
+    vec4 lightColor;
+};
 
 void main()
 {
     vec3 norm = normalize(Normal);
-    vec3 lightDirection = normalize(-lightDir);
+    vec3 lightDirection = normalize(-lightDir.xyz);
 
     // Ambient lighting (soft base light)
     float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColor.rgb;
 
     // Diffuse lighting
     float diff = max(dot(norm, lightDirection), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
 
     // Final color
-    vec3 result = (ambient + diffuse) * objectColor;
+    vec3 result = (ambient + diffuse) * ObjectColor;
     FragColor = vec4(result, 1.0);
 }
@@ -1,15 +1,42 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <iostream>
 #include <fstream>
-#include <sstream>
+#include <iostream>
+#include <string>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <vector>
+#include "AssetRegistry.h"
+#include "AsyncModelLoader.h"
+#include "ModelBatch.h"
 #include "ModelLoader.h"
 #include "stb_image.h"
 #include "Mat4.h"
-
-
+#include "ShaderProgram.h"
+#include "FrameData.h"
+#include "GLStateCache.h"
+#include "GeometryPool.h"
+#include "GpuProfiler.h"
+#include "Instancing.h"
+#include "MathBench.h"
+#include "OffscreenTarget.h"
+#include "RenderQueue.h"
+#include "RingBuffer.h"
+#include "SceneModel.h"
+#include "TransformHierarchy.h"
+#include "Vector3.h"
+
+
+
+constexpr int FRAME_WIDTH = 1920;
+constexpr int FRAME_HEIGHT = 1080;
+
+// Headless benchmark runs: frames rendered by default, and frames left out of
+// the statistics while drivers compile shaders and caches warm up
+const int HEADLESS_DEFAULT_FRAMES = 300;
+const int HEADLESS_WARMUP_FRAMES = 10;
 
 // Window resize callback
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -17,61 +44,22 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
-// Load shader source code from file
-std::string loadShaderSource(const char* filename)
-{
-    std::ifstream file(filename);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
+// Camera and light, shared by the view matrix and the FrameData block
+constexpr Vector3 CAMERA_EYE(0.0f, 1.2f, 4.5f);
+constexpr Vector3 CAMERA_TARGET(0.0f, 0.8f, 0.0f);
+constexpr Vector3 CAMERA_UP(0.0f, 1.0f, 0.0f);
+constexpr float CAMERA_NEAR = 0.1f;
+constexpr float CAMERA_FAR = 100.0f;
+constexpr float CAMERA_FOV = (float)CONST_PI / 4.0f;  // Vertical
 
-// Compile shader
-GLuint compileShader(GLenum type, const char* source)
-{
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-    return shader;
-}
-
-// Create shader program
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath)
-{
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
+constexpr Vector3 LIGHT_DIR(-0.5f, -1.0f, -0.3f);
+constexpr Vector3 LIGHT_COLOR(1.0f, 1.0f, 1.0f);
 
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str());
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
-
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    return shaderProgram;
-}
-
-
-
-Mat4 setupCamera()
-{
-    float eyeX = 0.0f;
-    float eyeY = 1.2f;  
-    float eyeZ = 4.5f;  
-
-    float centerX = 0.0f;
-    float centerY = 0.8f; 
-    float centerZ = 0.0f;
-
-    float upX = 0.0f;
-    float upY = 1.0f;
-    float upZ = 0.0f;
-
-    return Mat4::lookAt(eyeX, eyeY, eyeZ, centerX, centerY, centerZ, upX, upY, upZ);
-}
+// The camera is fixed, so its matrices are computed by the compiler
+constexpr Mat4 CAMERA_VIEW = Mat4::lookAt(CAMERA_EYE.x, CAMERA_EYE.y, CAMERA_EYE.z,
+    CAMERA_TARGET.x, CAMERA_TARGET.y, CAMERA_TARGET.z,
+    CAMERA_UP.x, CAMERA_UP.y, CAMERA_UP.z);
+constexpr Mat4 CAMERA_PROJECTION = Mat4::perspective(CAMERA_FOV, (float)FRAME_WIDTH / FRAME_HEIGHT, CAMERA_NEAR, CAMERA_FAR);
 
 
 // Scene variables
@@ -79,10 +67,35 @@ const float TABLE_WIDTH = 2.0f;
 const float TABLE_LENGTH = 1.5f;
 const float TABLE_HEIGHT = 0.1f;
 
-GLuint tableVAO, tableVBO, tableEBO, shaderProgram;
+// Every static position + normal mesh lives in this pool
+GeometryPool staticGeometry;
+
+// Per-frame instance data and indirect commands are streamed through this ring
+const GLsizeiptr STREAM_BYTES_PER_FRAME = 1 << 20;
+RingBuffer streamBuffer;
+
+InstancedMesh tableInstances;
+ShaderProgram shaderProgram;
 
 
 Mat4 view, projection;
+GLuint frameDataBuffer;
+RenderQueue renderQueue;
+TransformHierarchy sceneTransforms;
+GpuProfiler gpuProfiler;
+
+// Write camera and lighting into the shared FrameData block once per frame
+void updateFrameData()
+{
+    FrameData data = {};
+    memcpy(data.view, view.m, sizeof(data.view));
+    memcpy(data.projection, projection.m, sizeof(data.projection));
+    data.cameraPos[0] = CAMERA_EYE.x; data.cameraPos[1] = CAMERA_EYE.y; data.cameraPos[2] = CAMERA_EYE.z;
+    data.lightDir[0] = LIGHT_DIR.x; data.lightDir[1] = LIGHT_DIR.y; data.lightDir[2] = LIGHT_DIR.z;
+    data.lightColor[0] = LIGHT_COLOR.x; data.lightColor[1] = LIGHT_COLOR.y; data.lightColor[2] = LIGHT_COLOR.z;
+    updateFrameDataBuffer(frameDataBuffer, data);
+}
+
 void setupTable()
 {
     float halfWidth = TABLE_WIDTH * 0.5f;
@@ -148,82 +161,11 @@ void setupTable()
         20, 21, 22, 22, 23, 20
     };
 
-    glGenVertexArrays(1, &tableVAO);
-    glGenBuffers(1, &tableVBO);
-    glGenBuffers(1, &tableEBO);
-
-    glBindVertexArray(tableVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, tableVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tableEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-void drawTable()
-{
-    glUseProgram(shaderProgram);
-
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, -1.5f, 0.0f, -1.0f); 
-
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.8f, 0.6f, 0.4f);
-
-    glBindVertexArray(tableVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-}
-
-void drawTable2()
-{
-    glUseProgram(shaderProgram);
-
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, 1.5f, 0.0f, -1.0f); // Move table to the right
-
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.8f, 0.6f, 0.4f);
-
-    glBindVertexArray(tableVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    tableInstances.range = staticGeometry.add(vertices, sizeof(vertices) / sizeof(float), indices, sizeof(indices) / sizeof(unsigned int));
 }
 
 
-GLuint legsVAO, legsVBO, legsEBO;
+InstancedMesh legInstances;
 void setupLegs()
 {
     float halfWidth = TABLE_WIDTH * 0.5f;
@@ -271,81 +213,11 @@ void setupLegs()
         12, 13, 14, 14, 15, 12
     };
 
-    glGenVertexArrays(1, &legsVAO);
-    glGenBuffers(1, &legsVBO);
-    glGenBuffers(1, &legsEBO);
-
-    glBindVertexArray(legsVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, legsVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, legsEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    legInstances.range = staticGeometry.add(vertices, sizeof(vertices) / sizeof(float), indices, sizeof(indices) / sizeof(unsigned int));
 }
 
-void drawLegs()
-{
-    glUseProgram(shaderProgram);
-
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, -1.5f, 0.0f, -1.0f); 
 
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.8f, 0.6f, 0.4f);
-
-    glBindVertexArray(legsVAO);
-    glDrawElements(GL_TRIANGLES, 24, GL_UNSIGNED_INT, 0);
-}
-void drawLegs2()
-{
-    glUseProgram(shaderProgram);
-
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, 1.5f, 0.0f, -1.0f); 
-
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.8f, 0.6f, 0.4f); 
-
-    glBindVertexArray(legsVAO);
-    glDrawElements(GL_TRIANGLES, 24, GL_UNSIGNED_INT, 0);
-}
-
-
-GLuint groundVAO, groundVBO, groundEBO;
+InstancedMesh groundInstances;
 void setupGround()
 {
     float groundWidth = 14.0f;
@@ -411,53 +283,12 @@ void setupGround()
         20, 21, 22, 22, 23, 20
     };
 
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
-    glGenBuffers(1, &groundEBO);
-
-    glBindVertexArray(groundVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, groundEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-void drawGround()
-{
-    glUseProgram(shaderProgram);
-
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.1f, 0.1f, 0.1f); 
-
-    glBindVertexArray(groundVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    groundInstances.range = staticGeometry.add(vertices, sizeof(vertices) / sizeof(float), indices, sizeof(indices) / sizeof(unsigned int));
 }
 
 
-GLuint skyboxVAO, skyboxVBO, skyboxTexture, skyboxShaderProgram;
+GLuint skyboxVAO, skyboxVBO, skyboxTexture;
+ShaderProgram skyboxShaderProgram;
 
 std::vector<std::string> skyboxFaces = {
     "textures/posx.jpg",  // Right (+X)
@@ -474,7 +305,7 @@ GLuint loadCubemap(std::vector<std::string> faces)
 {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++)
@@ -549,8 +380,8 @@ void setupSkybox()
 
     glGenVertexArrays(1, &skyboxVAO);
     glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+    glState.bindVertexArray(skyboxVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -564,42 +395,61 @@ void setupSkybox()
 }
 
 
-void drawSkybox()
+void submitSkybox()
 {
-    glDepthFunc(GL_LEQUAL);
-    glUseProgram(skyboxShaderProgram);
-
-    Mat4 viewNoTranslation = view;
-    viewNoTranslation.m[12] = 0.0f;
-    viewNoTranslation.m[13] = 0.0f;
-    viewNoTranslation.m[14] = 0.0f;
-
-    GLuint viewLoc = glGetUniformLocation(skyboxShaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(skyboxShaderProgram, "projection");
-
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, viewNoTranslation.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-
-    glBindVertexArray(skyboxVAO);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-
-    glDepthFunc(GL_LESS);
+    DrawCommand command = {};
+    command.program = skyboxShaderProgram.id;
+    command.VAO = skyboxVAO;
+    command.textureTarget = GL_TEXTURE_CUBE_MAP;
+    command.texture = skyboxTexture;
+    command.depthFunc = GL_LEQUAL;  // Passes only where no opaque object wrote depth
+    command.indexed = false;
+    command.count = 36;
+    command.instanceCount = 1;
+    command.label = "skybox";
+    command.group = "skybox";
+
+    renderQueue.submit(makeSortKey(PASS_SKYBOX, command.program, skyboxTexture, command.VAO, 1.0f), command);
 }
 
 ModelLoader modelLoader;
-
-GLuint ballVAO, ballVBO, ballEBO;
-GLuint ballShaderProgram;
-
-void setupBall()
+AssetRegistry assets;
+
+// Loaded models drawn with the scene, textured and lit by texture_*_shader.glsl
+ShaderProgram modelShaderProgram;
+std::vector<SceneModel> placedModels;
+std::vector<DrawElementsIndirectCommand> modelCommands;  // Scratch of submitModel
+
+// Meshlet culling of the placed models at full detail (--meshlets)
+MeshletCullStats frameMeshlets;   // This frame's
+MeshletCullStats meshletTotals;   // Summed over the measured headless frames
+
+// A placed model is scaled to fit MODEL_FIT_RADIUS and centred modelDistance
+// in front of the camera (--model-distance), which drives its LOD. A
+// streamed model (--load-model) stands MODEL_SPACING to the right; batch
+// models (--import-batch) stand in a row MODEL_BATCH_ROW further back and
+// registry models (--load-assets) in one MODEL_ASSET_ROW back.
+const float MODEL_HEIGHT = 0.6f;
+const float MODEL_FIT_RADIUS = 0.5f;
+const float MODEL_SPACING = 1.2f;
+const float MODEL_BATCH_ROW = 1.5f;
+const float MODEL_ASSET_ROW = 3.0f;
+float modelDistance = 3.5f;
+
+// Models requested with --load-model stream in while frames keep rendering
+AsyncModelLoader modelStreamer;
+
+InstancedMesh ballInstances;
+ShaderProgram ballShaderProgram;
+
+// Ball tessellations, finest first; each one is a LOD of the ball
+const int BALL_LOD_SEGMENTS[] = { 24, 16, 8, 4 };
+const float BALL_RADIUS = 0.2f;
+
+// UV sphere with segments rings and segments slices
+void tessellateBall(int segments, float radius, std::vector<float>& vertices, std::vector<unsigned int>& indices)
 {
-    const int segments = 8;
-    const int rings = 8;
-    float radius = 0.2f;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-
+    const int rings = segments;
     for (int i = 0; i <= rings; i++)
     {
         float theta = (float)i / rings * 3.14159f;
@@ -643,93 +493,42 @@ void setupBall()
         }
     }
 
-    glGenVertexArrays(1, &ballVAO);
-    glGenBuffers(1, &ballVBO);
-    glGenBuffers(1, &ballEBO);
-
-    glBindVertexArray(ballVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, ballVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ballEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    ballShaderProgram = createShaderProgram("ball_vertex.glsl", "ball_fragment.glsl");
-}
-void drawBall()
-{
-    glUseProgram(ballShaderProgram);
-
-    GLuint modelLoc = glGetUniformLocation(ballShaderProgram, "model");
-    GLuint viewLoc = glGetUniformLocation(ballShaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(ballShaderProgram, "projection");
-    GLuint cameraPosLoc = glGetUniformLocation(ballShaderProgram, "cameraPos");
-    GLuint colorLoc = glGetUniformLocation(ballShaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, -1.0f, 0.5f, 0.5f);
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    
-    float eyeX = 0.0f;
-    float eyeY = 1.2f;  
-    float eyeZ = 4.5f;  
-
-    glUniform3f(cameraPosLoc, eyeX, eyeY, eyeZ); 
-
-    glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f);
-    glBindVertexArray(ballVAO);
-    glDrawElements(GL_TRIANGLES, 288, GL_UNSIGNED_INT, 0);
 }
 
-void drawBall2()
+void setupBall()
 {
-    glUseProgram(ballShaderProgram);
-
-    GLuint modelLoc = glGetUniformLocation(ballShaderProgram, "model");
-    GLuint viewLoc = glGetUniformLocation(ballShaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(ballShaderProgram, "projection");
-    GLuint cameraPosLoc = glGetUniformLocation(ballShaderProgram, "cameraPos");
-    GLuint colorLoc = glGetUniformLocation(ballShaderProgram, "objectColor");
-
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, 1.0f, 0.5f, 0.5f);
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-
-    float eyeX = 0.0f;
-    float eyeY = 1.2f;  
-    float eyeZ = 4.5f; 
-
-    glUniform3f(cameraPosLoc, eyeX, eyeY, eyeZ);
+    // A tessellation's largest distance to the true sphere is the sagitta of
+    // one slice, radius * (1 - cos(pi / segments))
+    for (size_t i = 0; i < sizeof(BALL_LOD_SEGMENTS) / sizeof(BALL_LOD_SEGMENTS[0]); i++)
+    {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        tessellateBall(BALL_LOD_SEGMENTS[i], BALL_RADIUS, vertices, indices);
+        MeshRange range = staticGeometry.add(vertices.data(), vertices.size(), indices.data(), indices.size());
+
+        LodLevel level;
+        level.firstIndex = range.firstIndex;
+        level.baseVertex = range.baseVertex;
+        level.indexCount = range.indexCount;
+        level.error = BALL_RADIUS * (1.0f - cosf((float)CONST_PI / BALL_LOD_SEGMENTS[i]));
+        ballInstances.lods.push_back(level);
+        if (i == 0)
+            ballInstances.range = range;
+    }
 
-    glUniform3f(colorLoc, 0.0f, 0.0f, 1.0f);
-    glBindVertexArray(ballVAO);
-    glDrawElements(GL_TRIANGLES, 288, GL_UNSIGNED_INT, 0);
+    ballShaderProgram = createShaderProgram("ball_vertex.glsl", "ball_fragment.glsl");
 }
 
 
-const float WALL_WIDTH = 10.0f;
-const float WALL_HEIGHT = 5.0f;
-const float WALL_THICKNESS = 0.1f;
+
+constexpr float WALL_WIDTH = 10.0f;
+constexpr float WALL_HEIGHT = 5.0f;
+constexpr float WALL_THICKNESS = 0.1f;
 const float WINDOW_WIDTH = 1.5f;
 const float WINDOW_HEIGHT = 1.2f;
+constexpr Mat4 WALL_MODEL = Mat4::translate(Mat4::identity(), 0.0f, WALL_HEIGHT * 0.5f - 1.0f, -2.5f);
 
-GLuint wallVAO, wallVBO, wallEBO;
+InstancedMesh wallInstances;
 
 void setupWall()
 {
@@ -772,74 +571,298 @@ void setupWall()
         12, 13, 14,  13, 15, 14  // New Single Top Part
     };
 
-    glGenVertexArrays(1, &wallVAO);
-    glGenBuffers(1, &wallVBO);
-    glGenBuffers(1, &wallEBO);
+    wallInstances.range = staticGeometry.add(vertices, sizeof(vertices) / sizeof(float), indices, sizeof(indices) / sizeof(unsigned int));
+}
 
-    glBindVertexArray(wallVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wallEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+// Place every repeated object as an instance of its mesh
+void setupInstances()
+{
+    // Each table and its legs share a node; the balls are placed relative to the tables
+    const Vector3 unitScale(1.0f, 1.0f, 1.0f);
+    int leftTable = sceneTransforms.add(TRANSFORM_ROOT, Vector3(-1.5f, 0.0f, -1.0f), Quat(), unitScale);
+    int rightTable = sceneTransforms.add(TRANSFORM_ROOT, Vector3(1.5f, 0.0f, -1.0f), Quat(), unitScale);
+    int leftBall = sceneTransforms.add(leftTable, Vector3(0.5f, 0.5f, 1.5f), Quat(), unitScale);
+    int rightBall = sceneTransforms.add(rightTable, Vector3(-0.5f, 0.5f, 1.5f), Quat(), unitScale);
+    sceneTransforms.updateWorld();
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    addInstance(tableInstances, sceneTransforms, leftTable, 0.8f, 0.6f, 0.4f);
+    addInstance(tableInstances, sceneTransforms, rightTable, 0.8f, 0.6f, 0.4f);
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    addInstance(legInstances, sceneTransforms, leftTable, 0.8f, 0.6f, 0.4f);
+    addInstance(legInstances, sceneTransforms, rightTable, 0.8f, 0.6f, 0.4f);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
+    addInstance(groundInstances, Mat4::identity(), 0.1f, 0.1f, 0.1f);
 
-void drawWall()
-{
-    glUseProgram(shaderProgram);
+    addInstance(ballInstances, sceneTransforms, leftBall, 1.0f, 0.0f, 0.0f);
+    addInstance(ballInstances, sceneTransforms, rightBall, 0.0f, 0.0f, 1.0f);
 
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
+    addInstance(wallInstances, WALL_MODEL, 0.4f, 0.3f, 0.2f);
 
+    attachInstanceBuffer(staticGeometry.VAO, streamBuffer.buffer);
+}
 
-    Mat4 model = Mat4::identity();
-    model = Mat4::translate(model, 0.0f, WALL_HEIGHT * 0.5f - 1.0f, -2.5f); 
+// View-space depth of the instance closest to the camera, scaled to [0, 1]
+float nearestInstanceDepth(const InstancedMesh& mesh)
+{
+    float nearest = CAMERA_FAR;
+    for (size_t i = 0; i < mesh.visible.size(); i++)
+    {
+        const float* model = mesh.visible[i].model;
+        float depth = -(view.m[2] * model[12] + view.m[6] * model[13] + view.m[10] * model[14] + view.m[14]);
+        if (depth < nearest)
+            nearest = depth;
+    }
+    return nearest / CAMERA_FAR;
+}
 
+// One draw for the visible instances, or one per LOD in use when the mesh has LODs
+void submitInstanced(const InstancedMesh& mesh, const ShaderProgram& program, const char* label, const char* group)
+{
+    if (mesh.visible.empty())
+        return;
+
+    DrawCommand command = {};
+    command.program = program.id;
+    command.VAO = staticGeometry.VAO;
+    command.depthFunc = GL_LESS;
+    command.indexed = true;
+    command.indexType = GL_UNSIGNED_INT;
+    command.count = mesh.range.indexCount;
+    command.instanceCount = (GLsizei)mesh.visible.size();
+    command.firstIndex = mesh.range.firstIndex;
+    command.baseVertex = mesh.range.baseVertex;
+    command.baseInstance = mesh.baseInstance;
+    command.label = label;
+    command.group = group;
+
+    uint64_t key = makeSortKey(PASS_OPAQUE, command.program, 0, command.VAO, nearestInstanceDepth(mesh));
+    if (mesh.lods.empty())
+    {
+        renderQueue.submit(key, command);
+        return;
+    }
 
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection.m);
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model.m);
+    for (size_t level = 0; level < mesh.lods.size() && level < MAX_LODS; level++)
+    {
+        if (mesh.lodVisible[level] == 0)
+            continue;
+        command.count = mesh.lods[level].indexCount;
+        command.instanceCount = mesh.lodVisible[level];
+        command.firstIndex = mesh.lods[level].firstIndex;
+        command.baseVertex = mesh.lods[level].baseVertex;
+        command.baseInstance = mesh.baseInstance + mesh.lodFirst[level];
+        renderQueue.submit(key, command);
+    }
+}
 
-    glUniform3f(lightDirLoc, -0.5f, -1.0f, -0.3f);
-    glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-    glUniform3f(objectColorLoc, 0.4f, 0.3f, 0.2f); 
+// offsetX is to the right of the view axis, row is farther from the camera
+Mat4 fitPlacement(const Mesh& mesh, float offsetX, float row)
+{
+    const BoundingSphere& sphere = mesh.bounds.sphere;
+    float scale = MODEL_FIT_RADIUS / std::max(sphere.radius, 1e-6f);
+    Mat4 placement = Mat4::translate(Mat4::identity(), CAMERA_EYE.x + offsetX, MODEL_HEIGHT, CAMERA_EYE.z - modelDistance - row);
+    placement = Mat4::scale(placement, scale, scale, scale);
+    return Mat4::translate(placement, -sphere.center.x, -sphere.center.y, -sphere.center.z);
+}
 
-    glBindVertexArray(wallVAO);
-    glDrawElements(GL_TRIANGLES, 24, GL_UNSIGNED_INT, 0);
+// One command per submesh, or per run of visible meshlets when the model is
+// at full detail and has them; they share program, VAO and texture, so the
+// queue merges the model into one multi-draw
+void submitModel(const SceneModel& model, const ShaderProgram& program, const Frustum& frustum)
+{
+    const Mesh& mesh = *model.mesh;
+    modelCommands.clear();
+    if (model.lod == 0 && !mesh.meshlets.empty())
+        appendVisibleMeshlets(mesh, model.placement, frustum, CAMERA_EYE, model.firstNodeInstance, modelCommands, &frameMeshlets);
+    else
+        appendDrawCommands(mesh, model.firstNodeInstance, modelCommands, model.lod);
+
+    DrawCommand command = {};
+    command.program = program.id;
+    command.VAO = mesh.VAO;
+    command.textureTarget = GL_TEXTURE_2D;
+    command.texture = model.texture ? model.texture : mesh.textureID;
+    command.depthFunc = GL_LESS;
+    command.indexed = true;
+    command.indexType = mesh.indexType;
+    command.label = "model";
+    command.group = "models";
+
+    const float* origin = model.placement.m + 12;
+    float depth = -(view.m[2] * origin[0] + view.m[6] * origin[1] + view.m[10] * origin[2] + view.m[14]);
+    uint64_t key = makeSortKey(PASS_OPAQUE, command.program, command.texture, command.VAO, depth / CAMERA_FAR);
+    for (size_t i = 0; i < modelCommands.size(); i++)
+    {
+        command.count = (GLsizei)modelCommands[i].count;
+        command.instanceCount = (GLsizei)modelCommands[i].instanceCount;
+        command.firstIndex = modelCommands[i].firstIndex;
+        command.baseVertex = modelCommands[i].baseVertex;
+        command.baseInstance = modelCommands[i].baseInstance;
+        renderQueue.submit(key, command);
+    }
 }
 
+// Only instances inside the view frustum are drawn. Opaque objects go front to
+// back, grouped by program, then the skybox. All static meshes of one program
+// go out as a single multi-draw.
+void drawScene()
+{
+    gpuProfiler.beginFrame();
+    gpuProfiler.begin("frame");
+    streamBuffer.beginFrame();
+    renderQueue.clear();
+
+    InstancedMesh* meshes[] = { &tableInstances, &legInstances, &groundInstances, &ballInstances, &wallInstances };
+    Frustum frustum = extractFrustum(projection * view);
+    sceneTransforms.updateWorld();
+    syncInstanceTransforms(sceneTransforms, meshes, sizeof(meshes) / sizeof(meshes[0]));
+    cullInstances(frustum, meshes, sizeof(meshes) / sizeof(meshes[0]));
+    selectInstanceLods(CAMERA_EYE, lodProjectionScale(CAMERA_FOV, (float)FRAME_HEIGHT), meshes, sizeof(meshes) / sizeof(meshes[0]));
+    if (writeInstances(streamBuffer, meshes, sizeof(meshes) / sizeof(meshes[0])))
+    {
+        submitInstanced(groundInstances, shaderProgram, "ground", "lit");
+        submitInstanced(tableInstances, shaderProgram, "tables", "lit");
+        submitInstanced(legInstances, shaderProgram, "legs", "lit");
+        submitInstanced(ballInstances, ballShaderProgram, "balls", "fresnel");
+        submitInstanced(wallInstances, shaderProgram, "wall", "lit");
+    }
+    frameMeshlets = MeshletCullStats();
+    cullModels(frustum, placedModels.data(), placedModels.size());
+    for (size_t i = 0; i < placedModels.size(); i++)
+    {
+        if (!placedModels[i].visible)
+            continue;
+        selectModelLod(placedModels[i], CAMERA_EYE, lodProjectionScale(CAMERA_FOV, (float)FRAME_HEIGHT));
+        if (writeModelNodes(streamBuffer, placedModels[i]))
+            submitModel(placedModels[i], modelShaderProgram, frustum);
+    }
+    submitSkybox();
 
+    renderQueue.sort();
+    renderQueue.flush(streamBuffer, &gpuProfiler);
+    streamBuffer.endFrame();
+    gpuProfiler.end();
+    gpuProfiler.endFrame();
+}
 
+// Print CPU frame time statistics of a headless run (sorts frameMs)
+void printFrameStats(std::vector<double>& frameMs)
+{
+    if (frameMs.empty())
+        return;
+
+    std::sort(frameMs.begin(), frameMs.end());
+    double total = 0.0;
+    for (size_t i = 0; i < frameMs.size(); i++)
+        total += frameMs[i];
+
+    size_t last = frameMs.size() - 1;
+    double average = total / frameMs.size();
+    std::cout << "Frames: " << frameMs.size() << " measured, " << HEADLESS_WARMUP_FRAMES << " warm-up" << std::endl;
+    std::cout << "Frame time (ms): avg " << average
+        << ", min " << frameMs[0]
+        << ", p50 " << frameMs[last / 2]
+        << ", p95 " << frameMs[last * 95 / 100]
+        << ", p99 " << frameMs[last * 99 / 100]
+        << ", max " << frameMs[last] << std::endl;
+    std::cout << "Average FPS: " << 1000.0 / average << std::endl;
+
+    if (meshletTotals.tested > 0)
+    {
+        size_t culled = meshletTotals.frustumCulled + meshletTotals.backfaceCulled;
+        std::cout << "Meshlets per frame: " << meshletTotals.tested / frameMs.size() << " tested, "
+            << meshletTotals.frustumCulled / frameMs.size() << " outside the frustum, "
+            << meshletTotals.backfaceCulled / frameMs.size() << " back-facing, "
+            << (meshletTotals.tested - culled) / frameMs.size() << " drawn" << std::endl;
+    }
+}
 
-void drawScene()
+// Batch list for --import-batch and --load-assets: one model per line, optionally followed by
+// a tab and its texture. Empty lines and lines starting with # are skipped.
+bool readBatchList(const char* path, std::vector<ModelRequest>& requests)
 {
-    drawSkybox();
-    drawGround();
-    drawTable();
-    drawLegs();
-    drawTable2();
-    drawLegs2();
-    drawBall();
-    drawBall2();
-    drawWall();
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open batch list: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        ModelRequest request;
+        size_t tab = line.find('\t');
+        request.modelPath = line.substr(0, tab);
+        if (tab != std::string::npos)
+            request.texturePath = line.substr(tab + 1);
+        requests.push_back(request);
+    }
+    return true;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    const char* gpuCsvPath = NULL;
+    bool headless = false;
+    int headlessFrames = HEADLESS_DEFAULT_FRAMES;
+    const char* dumpPath = NULL;
+    const char* comparePath = NULL;
+    const char* modelPath = NULL;
+    const char* modelTexturePath = "";
+    const char* streamModelPath = NULL;
+    const char* batchListPath = NULL;
+    const char* assetListPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--profile-draws")
+            renderQueue.mergeBatches = false;  // Time every object on its own
+        else if (arg == "--gpu-csv" && i + 1 < argc)
+            gpuCsvPath = argv[++i];
+        else if (arg == "--headless")
+            headless = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            headlessFrames = std::max(1, atoi(argv[++i]));
+        else if (arg == "--dump" && i + 1 < argc)
+            dumpPath = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc)
+            comparePath = argv[++i];  // E.g. a float dump, to check --quantized against
+        else if (arg == "--model" && i + 1 < argc)
+            modelPath = argv[++i];
+        else if (arg == "--model-texture" && i + 1 < argc)
+            modelTexturePath = argv[++i];  // For --model and --load-model
+        else if (arg == "--model-distance" && i + 1 < argc)
+            modelDistance = std::max(0.0f, (float)atof(argv[++i]));
+        else if (arg == "--quantized")
+        {
+            modelLoader.vertexFormat = VERTEX_FORMAT_QUANTIZED;  // 16-byte vertices for loaded models
+            modelStreamer.vertexFormat = VERTEX_FORMAT_QUANTIZED;
+        }
+        else if (arg == "--meshlets")
+        {
+            modelLoader.buildMeshlets = true;  // Placed models are culled per meshlet at full detail
+            modelStreamer.buildMeshlets = true;
+        }
+        else if (arg == "--load-model" && i + 1 < argc)
+            streamModelPath = argv[++i];
+        else if (arg == "--import-batch" && i + 1 < argc)
+            batchListPath = argv[++i];
+        else if (arg == "--load-assets" && i + 1 < argc)
+            assetListPath = argv[++i];
+        else if (arg == "--bench-mat4")
+            return runMat4Benchmark();  // CPU only, no window needed
+        else if (arg == "--bench-simd")
+            return runSimdBenchmark();
+    }
+
     if (!glfwInit())
         return -1;
 
@@ -847,7 +870,12 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(1920, 1080, "3D Scene", NULL, NULL);
+    // Headless runs keep the window hidden and only use it for its context;
+    // everything is drawn into an offscreen framebuffer
+    if (headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(FRAME_WIDTH, FRAME_HEIGHT, "3D Scene", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
@@ -858,8 +886,21 @@ int main()
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
         return -1;
 
-    glViewport(0, 0, 1920, 1080);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    OffscreenTarget offscreen;
+    if (headless)
+    {
+        if (!offscreen.create(FRAME_WIDTH, FRAME_HEIGHT))
+        {
+            glfwTerminate();
+            return -1;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreen.framebuffer);
+    }
+    else
+    {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
+    glViewport(0, 0, FRAME_WIDTH, FRAME_HEIGHT);
     glEnable(GL_DEPTH_TEST);
 
     // Load shaders
@@ -871,22 +912,175 @@ int main()
     setupGround();
     setupBall();
     setupWall();
+    staticGeometry.upload();
+    streamBuffer.create(STREAM_BYTES_PER_FRAME);
     setupSkybox();
+    setupInstances();
 
-    view = setupCamera();
-    projection = Mat4::perspective(3.14159f / 4.0f, 1920.0f / 1080.0f, 0.1f, 100.0f);
+    view = CAMERA_VIEW;
+    projection = CAMERA_PROJECTION;
+    frameDataBuffer = createFrameDataBuffer();
+    if (gpuCsvPath)
+        gpuProfiler.openCsv(gpuCsvPath);
 
-    while (!glfwWindowShouldClose(window))
+    modelShaderProgram = createShaderProgram("texture_vertex_shader.glsl", "texture_fragment_shader.glsl");
+    Mesh sceneMesh = {};
+    if (modelPath)
     {
+        sceneMesh = modelLoader.loadModel(modelPath, modelTexturePath);
+        if (sceneMesh.VAO)
+        {
+            attachInstanceBuffer(sceneMesh.VAO, streamBuffer.buffer);
+            SceneModel model;
+            model.mesh = &sceneMesh;
+            model.placement = fitPlacement(sceneMesh, 0.0f, 0.0f);
+            placedModels.push_back(model);
+        }
+    }
+
+    ModelBatch modelBatch;
+    std::vector<ModelRequest> batchRequests;
+    if (batchListPath && readBatchList(batchListPath, batchRequests))
+    {
+        ModelBatchLoader batchLoader;
+        batchLoader.load(batchRequests, modelBatch);
+        modelBatch.report(std::cout);
+
+        // Every model shares the batch's VAO, so the row is one multi-draw
+        // per texture
+        if (modelBatch.geometry.VAO)
+            attachInstanceBuffer(modelBatch.geometry.VAO, streamBuffer.buffer);
+        for (size_t i = 0; i < modelBatch.models.size(); i++)
+        {
+            if (!modelBatch.models[i].loaded)
+                continue;
+            SceneModel model;
+            model.mesh = &modelBatch.models[i].mesh;
+            float offsetX = ((float)i - (modelBatch.models.size() - 1) * 0.5f) * MODEL_SPACING;
+            model.placement = fitPlacement(*model.mesh, offsetX, MODEL_BATCH_ROW);
+            placedModels.push_back(model);
+        }
+    }
+
+    // Repeated paths in the list share one asset
+    std::vector<ModelRef> sceneModels;
+    std::vector<TextureRef> sceneTextures;
+    std::vector<ModelRequest> assetRequests;
+    if (assetListPath && readBatchList(assetListPath, assetRequests))
+    {
+        for (size_t i = 0; i < assetRequests.size(); i++)
+        {
+            ModelRef asset = assets.loadModel(assetRequests[i].modelPath);
+            TextureRef texture;
+            if (!assetRequests[i].texturePath.empty())
+                texture = assets.loadTexture(assetRequests[i].texturePath);
+            if (!asset)
+                continue;
+            sceneModels.push_back(asset);
+            if (texture)
+                sceneTextures.push_back(texture);
+
+            // Copies of one asset share its VAO, so attaching again is harmless
+            attachInstanceBuffer(asset->mesh.VAO, streamBuffer.buffer);
+            SceneModel model;
+            model.mesh = &asset->mesh;
+            model.texture = texture ? texture->textureID : 0;
+            float offsetX = ((float)i - (assetRequests.size() - 1) * 0.5f) * MODEL_SPACING;
+            model.placement = fitPlacement(*model.mesh, offsetX, MODEL_ASSET_ROW);
+            placedModels.push_back(model);
+        }
+        assets.report(std::cout);
+    }
+
+    ModelHandle streamedModel;
+    if (streamModelPath)
+    {
+        modelStreamer.start();
+        streamedModel = modelStreamer.load(streamModelPath, modelTexturePath);
+    }
+    bool streamReported = false;
+
+    std::vector<double> frameMs;
+    int frame = 0;
+    while (headless ? frame < headlessFrames : !glfwWindowShouldClose(window))
+    {
+        double frameStart = glfwGetTime();
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        updateFrameData();
         drawScene();
 
-        glfwSwapBuffers(window);
+        modelStreamer.update();
+        if (streamedModel.valid() && !streamReported && (streamedModel.ready() || streamedModel.failed()))
+        {
+            if (streamedModel.ready())
+            {
+                std::cout << "Model " << streamModelPath << " ready after " << frame + 1 << " frames ("
+                    << streamedModel.mesh()->submeshes.size() << " submeshes)" << std::endl;
+
+                // Drawn from the next frame on
+                attachInstanceBuffer(streamedModel.mesh()->VAO, streamBuffer.buffer);
+                SceneModel model;
+                model.mesh = streamedModel.mesh();
+                model.placement = fitPlacement(*model.mesh, MODEL_SPACING, 0.0f);
+                placedModels.push_back(model);
+            }
+            streamReported = true;
+        }
+
+        if (headless)
+        {
+            // Nothing is presented, so wait for the GPU to count its work in the frame time
+            glFinish();
+            if (frame >= HEADLESS_WARMUP_FRAMES)
+            {
+                frameMs.push_back((glfwGetTime() - frameStart) * 1000.0);
+                meshletTotals.tested += frameMeshlets.tested;
+                meshletTotals.frustumCulled += frameMeshlets.frustumCulled;
+                meshletTotals.backfaceCulled += frameMeshlets.backfaceCulled;
+            }
+        }
+        else
+        {
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+        frame++;
+    }
+
+    if (headless)
+    {
+        printFrameStats(frameMs);
+        if (dumpPath && offscreen.writePpm(dumpPath))
+            std::cout << "Last frame written to " << dumpPath << std::endl;
+        if (comparePath)
+            offscreen.comparePpm(comparePath, std::cout);
+        offscreen.destroy();
     }
 
+    for (size_t i = 0; i < placedModels.size(); i++)
+    {
+        std::cout << "Placed model " << i << ": LOD " << placedModels[i].lod << " of "
+            << placedModels[i].mesh->lodCount << " (" << placedModels[i].mesh->submeshes.size() << " submeshes)" << std::endl;
+    }
+
+    std::cout << "GL state cache: " << glState.issued << " binds issued, "
+        << glState.skipped << " redundant binds skipped" << std::endl;
+    std::cout << "Stream ring: " << streamBuffer.fenceWaits << " fence waits in " << streamBuffer.frames
+        << " frames (" << streamBuffer.fenceWaitMs << " ms blocked), "
+        << streamBuffer.failedAllocations << " failed allocations" << std::endl;
+
+    gpuProfiler.report(std::cout);
+
+    modelStreamer.stop();
+    modelBatch.destroy();
+    sceneModels.clear();  // Assets free their GL objects, so before the context goes
+    sceneTextures.clear();
+    streamBuffer.destroy();
+    gpuProfiler.destroy();
+
     glfwTerminate();
     return 0;
 }
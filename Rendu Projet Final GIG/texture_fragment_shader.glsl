@@ -6,22 +6,29 @@ in vec2 TexCoord;
 
 out vec4 FragColor;
 
-uniform vec3 lightDir;
-uniform vec3 lightColor;
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightDir;
+    vec4 lightColor;
+};
+
 uniform sampler2D texture1;
 
 void main()
 {
     vec3 norm = normalize(Normal);
-    vec3 lightDirection = normalize(-lightDir);
+    vec3 lightDirection = normalize(-lightDir.xyz);
 
     // Ambient lighting
     float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColor.rgb;
 
     // Diffuse lighting
     float diff = max(dot(norm, lightDirection), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
 
     // Sample the texture
     vec3 textureColor = texture(texture1, TexCoord).rgb;
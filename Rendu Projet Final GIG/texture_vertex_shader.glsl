@@ -4,19 +4,30 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
+// One instance per model node (see SceneModel.h); each submesh's draw picks
+// its node through baseInstance
+layout (location = 3) in mat4 instanceModel;    // Per node, locations 3-6, dequantization folded in
+layout (location = 7) in mat3 instanceNormal;   // Per node, locations 7-9
+layout (location = 10) in vec4 instanceTexCoordTransform;  // UV offset in xy, scale in zw
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightDir;
+    vec4 lightColor;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalize(mat3(model) * aNormal);
-    TexCoord = aTexCoord; 
+    FragPos = vec3(instanceModel * vec4(aPos, 1.0));
+    Normal = instanceNormal * aNormal;
+    TexCoord = instanceTexCoordTransform.xy + instanceTexCoordTransform.zw * aTexCoord;
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * instanceModel * vec4(aPos, 1.0);
 }
@@ -2,18 +2,28 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 3) in mat4 instanceModel;  // Per instance, locations 3-6
+layout (location = 7) in mat3 instanceNormal;  // Per instance, locations 7-9
+layout (location = 10) in vec4 instanceColor;
 
 out vec3 FragPos;
 out vec3 Normal;
+flat out vec3 ObjectColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightDir;
+    vec4 lightColor;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    FragPos = vec3(instanceModel * vec4(aPos, 1.0));
+    Normal = instanceNormal * aNormal;
+    ObjectColor = instanceColor.rgb;
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * instanceModel * vec4(aPos, 1.0);
 }